@@ -112,6 +112,7 @@ void ofApp::update() {
     const int impulsesToEmit = static_cast<int>(std::floor(autoImpulseAccumulator));
     autoImpulseAccumulator -= static_cast<float>(impulsesToEmit);
 
+    autoImpulses.clear();
     for (int i = 0; i < impulsesToEmit; ++i) {
       FluidSimulation::Impulse impulse {
         { ofRandom(ofGetWidth()) * SCALE, ofRandom(ofGetHeight()) * SCALE },
@@ -122,8 +123,11 @@ void ofApp::update() {
         ofFloatColor(0.2f + ofRandom(0.4f), 0.05f + ofRandom(0.3f), 0.1f + ofRandom(0.3f), autoImpulseColorAlphaParameter.get()),
         1.0f,
       };
-      fluidSimulation.applyImpulse(impulse);
-      if (autoTemperatureParameter.get()) {
+      autoImpulses.push_back(impulse);
+    }
+    fluidSimulation.applyImpulses(autoImpulses);
+    if (autoTemperatureParameter.get()) {
+      for (const auto& impulse : autoImpulses) {
         fluidSimulation.applyTemperatureImpulse(impulse.position, impulse.radius, autoTemperatureDeltaParameter.get());
       }
     }
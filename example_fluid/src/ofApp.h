@@ -71,6 +71,7 @@ private:
   ofParameter<bool> autoTemperatureParameter { "Auto Temperature", false };
   ofParameter<float> autoTemperatureDeltaParameter { "Auto Temp Delta", 0.8f, -2.0f, 2.0f };
   float autoImpulseAccumulator = 0.0f;
+  std::vector<FluidSimulation::Impulse> autoImpulses;
 
   ofParameter<bool> constantDriftParameter { "Constant Drift", false };
   ofParameter<glm::vec2> driftVelocityParameter { "Drift Velocity", { 0.0f, 0.0f }, { -2.0f, -2.0f }, { 2.0f, 2.0f } };
@@ -0,0 +1,65 @@
+#!/usr/bin/env bash
+# Runs every checked scenario against its golden image in this directory, or with --write
+# regenerates them. Run from anywhere after building example_headless; extra arguments (e.g.
+# --tolerance) are passed to every run. A run whose golden hasn't been generated yet still runs
+# (and checks its reference, if it has one) but skips the golden comparison. Exits non-zero if
+# any run fails or drifts.
+set -u
+cd "$(dirname "$0")"
+HARNESS=../bin/example_headless
+export LIBGL_ALWAYS_SOFTWARE=1
+
+MODE=--golden
+if [ "${1:-}" = "--write" ]; then MODE=--write-golden; shift; fi
+
+# Drift between Mesa versions and CPUs is well under this; a real change usually isn't.
+TOLERANCE="--tolerance 1e-3 --max-bad-fraction 0.001"
+COMMON="--size 128x128 --frames 120 --seed 1"
+failed=0
+missing=()
+
+# run GOLDEN SCENARIO [ARGS...]; ARGS override COMMON
+run() {
+  local golden=$1 scenario=$2; shift 2
+  echo "== $golden"
+  local output=($MODE "$golden.gold")
+  if [ "$MODE" = --golden ] && [ ! -f "$golden.gold" ]; then
+    echo "no $golden.gold yet: skipping the golden comparison (generate it with check.sh --write)"
+    missing+=("$golden")
+    output=()
+  fi
+  "$HARNESS" "$scenario" $COMMON $TOLERANCE "$@" "${output[@]}" "${EXTRA[@]}" || failed=1
+}
+
+EXTRA=("$@")
+run fluid fluid
+run fluid-fused fluid --set "Fused Passes=1"
+run fluid-sor fluid --set "Pressure Solver=2" --set "Diffusion Solver=1"
+run fluid-multigrid fluid --set "Pressure Solver=1"
+run fluid-adaptive fluid --set "Pressure Adaptive=1"
+run fluid-sleep fluid --set "Sleep Enabled=1"
+run fluid-tiled fluid --set "Tiled=1"
+run fluid-substep fluid --set "CFL Mode=1" --set "dt=0.002"
+# Two paths side by side, checked against each other as well as the golden (see FluidCheckScenario)
+CHECK="--frames 30 --reference-tolerance 1e-3"
+run fluid-fused-check fluid-fused-check $CHECK
+run fluid-fused-check-wrap fluid-fused-check $CHECK --set "Boundary Mode=1"
+# Direct passes run the same shaders on the same texels, so they must match exactly
+run fluid-direct-check fluid-direct-check --reference-tolerance 0
+# Tiled: both issue their passes over the active tile quads (FluidCheckScenario steps like update())
+run fluid-direct-check-tiled fluid-direct-check --reference-tolerance 0 --set "Tiled=1"
+run fluid-direct-check-multigrid fluid-direct-check --reference-tolerance 0 --set "Pressure Solver=1"
+run smear smear
+run softcircle softcircle
+run flowfield flowfield
+
+# Direct passes must reproduce the fbo passes, so they check against the same golden
+if [ "$MODE" = --golden ]; then
+  run fluid fluid --pass-mode direct
+  run fluid-tiled fluid --pass-mode direct --set "Tiled=1"
+fi
+
+if [ ${#missing[@]} -gt 0 ]; then
+  echo "${#missing[@]} run(s) had no golden to compare against: ${missing[*]}"
+fi
+exit $failed
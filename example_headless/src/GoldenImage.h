@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ofMain.h"
+
+// A float RGBA snapshot of an fbo, stored raw so comparisons see the full precision of float
+// targets: "OFXGOLD1", then width, height and channel count as uint32, then the texels bottom
+// row first (GL order). Files are native-endian.
+struct GoldenImage {
+  static constexpr char MAGIC[8] = { 'O', 'F', 'X', 'G', 'O', 'L', 'D', '1' };
+  static constexpr uint32_t CHANNELS = 4;
+
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<float> texels; // width * height * CHANNELS
+
+  // Waits for the GPU.
+  static GoldenImage read(const ofFbo& fbo) {
+    GoldenImage image;
+    image.width = static_cast<uint32_t>(fbo.getWidth());
+    image.height = static_cast<uint32_t>(fbo.getHeight());
+    image.texels.resize(static_cast<size_t>(image.width) * image.height * CHANNELS);
+    GLint previousReadFramebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.getId());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, image.width, image.height, GL_RGBA, GL_FLOAT, image.texels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFramebuffer);
+    return image;
+  }
+
+  bool save(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+      ofLogError("GoldenImage") << "can't open " << path;
+      return false;
+    }
+    const uint32_t header[3] = { width, height, CHANNELS };
+    bool ok = std::fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1
+              && std::fwrite(header, sizeof(header), 1, file) == 1
+              && std::fwrite(texels.data(), sizeof(float), texels.size(), file) == texels.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) ofLogError("GoldenImage") << "can't write " << path;
+    return ok;
+  }
+
+  bool load(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+      ofLogError("GoldenImage") << "can't open " << path;
+      return false;
+    }
+    char magic[sizeof(MAGIC)] = {};
+    uint32_t header[3] = {};
+    bool ok = std::fread(magic, sizeof(magic), 1, file) == 1 && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+              && std::fread(header, sizeof(header), 1, file) == 1 && header[2] == CHANNELS;
+    if (ok) {
+      width = header[0];
+      height = header[1];
+      texels.resize(static_cast<size_t>(width) * height * CHANNELS);
+      ok = std::fread(texels.data(), sizeof(float), texels.size(), file) == texels.size();
+    }
+    std::fclose(file);
+    if (!ok) ofLogError("GoldenImage") << path << " is not a golden image";
+    return ok;
+  }
+};
+
+// How far an image drifted from its golden. A channel is bad when it differs by more than
+// absoluteTolerance + relativeTolerance * |golden|, or when exactly one of the two is NaN.
+struct GoldenComparison {
+  bool sizeMatches = false;
+  float maxAbsoluteError = 0.0f;
+  float rmsError = 0.0f;
+  size_t badChannels = 0;
+  size_t channels = 0;
+  size_t firstBadTexel = 0; // valid when badChannels > 0
+
+  float badFraction() const { return channels ? static_cast<float>(badChannels) / channels : 0.0f; }
+
+  bool passes(float maxBadFraction) const { return sizeMatches && badFraction() <= maxBadFraction; }
+
+  static GoldenComparison compare(const GoldenImage& image, const GoldenImage& golden,
+                                  float absoluteTolerance, float relativeTolerance) {
+    GoldenComparison result;
+    result.sizeMatches = image.width == golden.width && image.height == golden.height;
+    if (!result.sizeMatches) return result;
+    result.channels = image.texels.size();
+    double sumSquares = 0.0;
+    size_t finiteCount = 0;
+    for (size_t i = 0; i < result.channels; ++i) {
+      const float value = image.texels[i];
+      const float expected = golden.texels[i];
+      if (std::isnan(value) || std::isnan(expected)) {
+        if (std::isnan(value) != std::isnan(expected)) result.addBad(i);
+        continue;
+      }
+      const float error = std::abs(value - expected);
+      result.maxAbsoluteError = std::max(result.maxAbsoluteError, error);
+      sumSquares += static_cast<double>(error) * error;
+      ++finiteCount;
+      if (!(error <= absoluteTolerance + relativeTolerance * std::abs(expected))) result.addBad(i);
+    }
+    result.rmsError = finiteCount ? static_cast<float>(std::sqrt(sumSquares / finiteCount)) : 0.0f;
+    return result;
+  }
+
+private:
+  void addBad(size_t channel) {
+    if (badChannels++ == 0) firstBadTexel = channel / GoldenImage::CHANNELS;
+  }
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofGLProgrammableRenderer.h"
+
+#define EGL_NO_X11 // keep X11's None/Status/Bool macros out
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// A window-less OF window for Linux: an EGL context on Mesa's surfaceless platform, so it needs
+// no display server and runs on llvmpipe with no GPU. There is no default framebuffer; render
+// into fbos and read those back. Modelled on ofAppNoWindow, and driven by the normal main loop:
+//
+//   ofInit();
+//   auto window = std::make_shared<HeadlessEglWindow>();
+//   ofGetMainLoop()->addWindow(window);
+//   window->setup(settings); // ofGLWindowSettings: GL version and nominal size
+//   ofRunApp(window, app);
+//   ofRunMainLoop();
+class HeadlessEglWindow : public ofAppBaseGLWindow {
+
+public:
+  ~HeadlessEglWindow() override { close(); }
+
+  static void loop() {}
+  static bool doesLoop() { return false; }
+  static bool allowsMultiWindow() { return false; }
+  static bool needsPolling() { return false; }
+  static void pollEvents() {}
+
+  using ofAppBaseGLWindow::setup;
+  void setup(const ofGLWindowSettings& settings) override {
+    width = settings.getWidth();
+    height = settings.getHeight();
+    if (!createContext(settings.glVersionMajor, settings.glVersionMinor)) {
+      ofLogError("HeadlessEglWindow") << "no GL " << settings.glVersionMajor << "." << settings.glVersionMinor
+                                      << " core context; exiting";
+      std::exit(2);
+    }
+
+    glewExperimental = GL_TRUE;
+    const GLenum glewError = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW built for GLX also looks for an X display; the GL entry points are loaded regardless.
+    if (glewError != GLEW_OK && glewError != GLEW_ERROR_NO_GLX_DISPLAY) {
+#else
+    if (glewError != GLEW_OK) {
+#endif
+      ofLogError("HeadlessEglWindow") << "glewInit: " << glewGetErrorString(glewError);
+    }
+
+    currentRenderer = std::make_shared<ofGLProgrammableRenderer>(this);
+    static_cast<ofGLProgrammableRenderer*>(currentRenderer.get())->setup(settings.glVersionMajor, settings.glVersionMinor);
+    ofLogNotice("HeadlessEglWindow") << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION);
+  }
+
+  void update() override { coreEvents.notifyUpdate(); }
+
+  void draw() override {
+    currentRenderer->startRender();
+    coreEvents.notifyDraw();
+    currentRenderer->finishRender();
+  }
+
+  bool getWindowShouldClose() override { return shouldClose; }
+  void setWindowShouldClose() override { shouldClose = true; }
+
+  void close() override {
+    if (display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+    surface = EGL_NO_SURFACE;
+    context = EGL_NO_CONTEXT;
+  }
+
+  void makeCurrent() override {
+    if (display != EGL_NO_DISPLAY) eglMakeCurrent(display, surface, surface, context);
+  }
+
+  ofCoreEvents& events() override { return coreEvents; }
+  std::shared_ptr<ofBaseRenderer>& renderer() override { return currentRenderer; }
+
+  glm::vec2 getWindowPosition() override { return { 0.0f, 0.0f }; }
+  glm::vec2 getWindowSize() override { return glm::vec2(width, height); }
+  glm::vec2 getScreenSize() override { return glm::vec2(width, height); }
+  int getWidth() override { return width; }
+  int getHeight() override { return height; }
+  ofWindowMode getWindowMode() override { return OF_WINDOW; }
+
+private:
+  bool createContext(int major, int minor) {
+    display = getDisplay();
+    EGLint eglMajor = 0, eglMinor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &eglMajor, &eglMinor)) {
+      ofLogError("HeadlessEglWindow") << "can't initialise an EGL display";
+      display = EGL_NO_DISPLAY;
+      return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+      ofLogError("HeadlessEglWindow") << "EGL has no desktop GL";
+      return false;
+    }
+
+    const EGLint configAttributes[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+      EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+      ofLogError("HeadlessEglWindow") << "no EGL config for desktop GL";
+      return false;
+    }
+
+    const EGLint contextAttributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION, major,
+      EGL_CONTEXT_MINOR_VERSION, minor,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) return false;
+
+    // EGL_KHR_surfaceless_context; otherwise fall back to a small pbuffer that is never drawn to.
+    if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return true;
+    const EGLint pbufferAttributes[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+    return surface != EGL_NO_SURFACE && eglMakeCurrent(display, surface, surface, context);
+  }
+
+  static EGLDisplay getDisplay() {
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+      EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+      if (surfaceless != EGL_NO_DISPLAY) return surfaceless;
+    }
+#endif
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+
+  ofCoreEvents coreEvents;
+  std::shared_ptr<ofBaseRenderer> currentRenderer;
+  EGLDisplay display = EGL_NO_DISPLAY;
+  EGLSurface surface = EGL_NO_SURFACE;
+  EGLContext context = EGL_NO_CONTEXT;
+  int width = 0;
+  int height = 0;
+  bool shouldClose = false;
+};
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "ofMain.h"
+#include "FluidSimulation.h"
+#include "FluidEventReplay.h"
+#include "FlowFieldRenderer.h"
+#include "PingPongFbo.h"
+#include "Shader.h"
+#include "SmearShader.h"
+#include "SoftCircleShader.h"
+
+// A fixed workload for the headless harness. Everything a scenario does must follow from its
+// seed and the frame index (never the clock or ofRandom), so a run is reproducible and its
+// result can be compared against a golden image.
+class Scenario {
+public:
+  static constexpr float FRAME_DT = 1.0f / 60.0f;
+
+  virtual ~Scenario() {}
+  // Returns false if the scenario can't run.
+  virtual bool setup(int width, int height, uint32_t seed) = 0;
+  virtual void frame(int index) = 0;
+  // True once the scenario has run out of input before the requested frame count.
+  virtual bool isFinished() const { return false; }
+  // The fbo compared against the golden image.
+  virtual const ofFbo& getResult() = 0;
+  // Called before setup(). Returns false if the scenario has no passes to switch.
+  virtual bool setPassMode(Shader::PassMode passMode) { return false; }
+  // The parameters --set overrides, in every group that has the name. Valid after setup().
+  virtual std::vector<ofParameterGroup*> getParameters() { return {}; }
+  // For scenarios that run two paths side by side: the fbo getResult() must match.
+  virtual const ofFbo* getReference() { return nullptr; }
+
+protected:
+  // Uniform in [0, 1); std::mt19937's sequence is fixed by the standard, unlike the distributions.
+  float random() { return static_cast<float>(rng() >> 8) * (1.0f / 16777216.0f); }
+
+  std::mt19937 rng;
+};
+
+// Stirs the fluid with a couple of random impulses a frame for STIR_FRAMES frames, then lets it
+// settle (so sleep can engage), stepping it the way update() does at a fixed dt: sleep, tiles
+// and the substep count follow the lagged GPU measurements, which the harness's glFinish()
+// after every frame makes arrive on a fixed frame.
+class FluidScenario : public Scenario {
+public:
+  static constexpr int STIR_FRAMES = 60;
+
+  bool setup(int width_, int height_, uint32_t seed) override {
+    rng.seed(seed);
+    size = glm::vec2(width_, height_);
+    fluidSimulation.setup(size);
+    // The first frame's impulses come before any step, so give them the fixed dt too
+    fluidSimulation.setImpulseFrameDt(FRAME_DT);
+    return true;
+  }
+
+  void frame(int index) override {
+    makeImpulses(index);
+    fluidSimulation.applyImpulses(impulses);
+    fluidSimulation.stepFrame(FRAME_DT, 1);
+  }
+
+  const ofFbo& getResult() override { return fluidSimulation.getFlowValuesFbo().getSource(); }
+
+  bool setPassMode(Shader::PassMode passMode) override {
+    fluidSimulation.setPassMode(passMode);
+    return true;
+  }
+
+  std::vector<ofParameterGroup*> getParameters() override { return { &fluidSimulation.getParameterGroup() }; }
+
+protected:
+  // A couple of random impulses, or none once the frame is past STIR_FRAMES
+  void makeImpulses(int index) {
+    impulses.clear();
+    if (index >= STIR_FRAMES) return;
+    const float radius = 0.05f * std::min(size.x, size.y);
+    for (int i = 0; i < 2; ++i) {
+      FluidSimulation::Impulse impulse;
+      impulse.position = { random() * size.x, random() * size.y };
+      impulse.radius = radius;
+      impulse.velocity = { (random() - 0.5f) * 8.0f, (random() - 0.5f) * 8.0f };
+      impulse.radialVelocity = 1.5f;
+      impulse.swirlVelocity = (random() - 0.5f) * 4.0f;
+      impulse.color = ofFloatColor(random(), random(), random(), 1.0f);
+      impulse.colorDensity = 0.1f;
+      impulses.push_back(impulse);
+    }
+  }
+
+  glm::vec2 size;
+  FluidSimulation fluidSimulation;
+  std::vector<FluidSimulation::Impulse> impulses;
+};
+
+// Replays a FluidEventRecorder log (impulses and parameter changes), each frame with the
+// recorded dt and step count. The size and parameters should match the recording's.
+class FluidReplayScenario : public FluidScenario {
+public:
+  explicit FluidReplayScenario(const std::string& path_) : path(path_) {}
+
+  bool setup(int width_, int height_, uint32_t seed) override {
+    FluidScenario::setup(width_, height_, seed);
+    return replay.open(path);
+  }
+
+  void frame(int index) override {
+    if (!replay.replayFrame(fluidSimulation)) finished = true;
+  }
+
+  bool isFinished() const override { return finished; }
+
+private:
+  std::string path;
+  FluidEventReplay replay;
+  bool finished = false;
+};
+
+// Runs FluidScenario's impulses through a second simulation that configureVariant switches to
+// another path, and checks its velocities against the first's (the reference). --set and
+// --pass-mode apply to both; configureVariant runs after them, before setup.
+class FluidCheckScenario : public FluidScenario {
+public:
+  using Configure = std::function<void(FluidSimulation&)>;
+
+  explicit FluidCheckScenario(Configure configureVariant_) : configureVariant(std::move(configureVariant_)) {}
+
+  bool setup(int width_, int height_, uint32_t seed) override {
+    configureVariant(variantSimulation);
+    FluidScenario::setup(width_, height_, seed);
+    variantSimulation.setup(size);
+    variantSimulation.setImpulseFrameDt(FRAME_DT);
+    return true;
+  }
+
+  void frame(int index) override {
+    makeImpulses(index);
+    for (FluidSimulation* simulation : { &fluidSimulation, &variantSimulation }) {
+      simulation->applyImpulses(impulses);
+      simulation->stepFrame(FRAME_DT, 1);
+    }
+  }
+
+  const ofFbo& getResult() override { return variantSimulation.getFlowVelocitiesFbo().getSource(); }
+
+  const ofFbo* getReference() override { return &fluidSimulation.getFlowVelocitiesFbo().getSource(); }
+
+  bool setPassMode(Shader::PassMode passMode) override {
+    fluidSimulation.setPassMode(passMode);
+    variantSimulation.setPassMode(passMode);
+    return true;
+  }
+
+  std::vector<ofParameterGroup*> getParameters() override {
+    return { &fluidSimulation.getParameterGroup(), &variantSimulation.getParameterGroup() };
+  }
+
+private:
+  Configure configureVariant;
+  FluidSimulation variantSimulation;
+};
+
+// Stamps a few soft circles per frame into a float buffer and smears it through two GPU flow
+// fields, as example_smear_field does.
+class SmearScenario : public Scenario {
+public:
+  bool setup(int width_, int height_, uint32_t seed) override {
+    rng.seed(seed);
+    size = glm::vec2(width_, height_);
+    fbo.allocate(size, GL_RGBA32F);
+    fbo.clearFloat(0.0f, 0.0f, 0.0f, 0.0f);
+    smearShader.load();
+    softCircleShader.load();
+    field1Renderer.load();
+    field1Renderer.allocate(width_ / 4, height_ / 4);
+    field1Renderer.seedParameter = static_cast<int>(seed % 1000);
+    field2Renderer.load();
+    field2Renderer.allocate(width_ / 4, height_ / 4);
+    field2Renderer.seedParameter = static_cast<int>((seed + 1) % 1000);
+    field2Renderer.curlParameter = true;
+    return true;
+  }
+
+  void frame(int index) override {
+    const float time = index * FRAME_DT;
+    field1Renderer.update(time);
+    field2Renderer.update(time);
+
+    stamps.clear();
+    for (int i = 0; i < 4; ++i) {
+      SoftCircleShader::Stamp stamp;
+      stamp.center = { random() * size.x, random() * size.y };
+      const float diameter = (0.02f + 0.06f * random()) * size.x;
+      stamp.size = { diameter, diameter };
+      stamp.color = ofFloatColor(random(), random(), random(), 1.0f);
+      stamps.push_back(stamp); // edgeAmount 0: the edge drift follows the clock
+    }
+    fbo.getSource().begin();
+    ofEnableBlendMode(OF_BLENDMODE_ALPHA);
+    softCircleShader.renderBatch(stamps);
+    fbo.getSource().end();
+
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    smearShader.render(fbo, { 0.0f, 0.0001f }, 0.9f, 0.998f,
+                       field1Renderer.getTexture(), 0.002f, { -0.5f, -0.5f },
+                       field2Renderer.getTexture(), 0.008f, { -0.5f, -0.5f });
+  }
+
+  const ofFbo& getResult() override { return fbo.getSource(); }
+
+private:
+  glm::vec2 size;
+  PingPongFbo fbo;
+  SmearShader smearShader;
+  SoftCircleShader softCircleShader;
+  FlowFieldRenderer field1Renderer;
+  FlowFieldRenderer field2Renderer;
+  std::vector<SoftCircleShader::Stamp> stamps;
+};
+
+// Accumulates a batch of random soft circles per frame.
+class SoftCircleScenario : public Scenario {
+public:
+  bool setup(int width_, int height_, uint32_t seed) override {
+    rng.seed(seed);
+    size = glm::vec2(width_, height_);
+    fbo.allocate(width_, height_, GL_RGBA32F);
+    fbo.begin();
+    ofClear(0, 0);
+    fbo.end();
+    softCircleShader.load();
+    return true;
+  }
+
+  void frame(int index) override {
+    stamps.clear();
+    for (int i = 0; i < 64; ++i) {
+      SoftCircleShader::Stamp stamp;
+      stamp.center = { random() * size.x, random() * size.y };
+      stamp.size = { (0.01f + 0.1f * random()) * size.x, (0.01f + 0.1f * random()) * size.x };
+      stamp.angleRad = random() * glm::two_pi<float>();
+      stamp.color = ofFloatColor(random(), random(), random(), 0.2f);
+      stamp.falloff = i % 2;
+      stamps.push_back(stamp);
+    }
+    fbo.begin();
+    ofEnableBlendMode(OF_BLENDMODE_ALPHA);
+    softCircleShader.renderBatch(stamps);
+    fbo.end();
+  }
+
+  const ofFbo& getResult() override { return fbo; }
+
+private:
+  glm::vec2 size;
+  ofFbo fbo;
+  SoftCircleShader softCircleShader;
+  std::vector<SoftCircleShader::Stamp> stamps;
+};
+
+// Redraws a curl-noise flow field every frame (time quantum 0).
+class FlowFieldScenario : public Scenario {
+public:
+  bool setup(int width_, int height_, uint32_t seed) override {
+    flowFieldRenderer.load();
+    flowFieldRenderer.allocate(width_, height_);
+    flowFieldRenderer.seedParameter = static_cast<int>(seed % 1000);
+    flowFieldRenderer.curlParameter = true;
+    flowFieldRenderer.timeQuantumParameter = 0.0f;
+    return true;
+  }
+
+  void frame(int index) override { flowFieldRenderer.update(index * FRAME_DT); }
+
+  const ofFbo& getResult() override { return flowFieldRenderer.getFbo(); }
+
+  std::vector<ofParameterGroup*> getParameters() override { return { &flowFieldRenderer.getParameterGroup() }; }
+
+private:
+  FlowFieldRenderer flowFieldRenderer;
+};
+
+// The parameter called name in group or any group nested in it, or nullptr.
+inline ofAbstractParameter* findParameter(ofParameterGroup& group, const std::string& name) {
+  for (size_t i = 0; i < group.size(); ++i) {
+    ofAbstractParameter& parameter = group.get(i);
+    if (parameter.type() == typeid(ofParameterGroup).name()) {
+      if (auto found = findParameter(parameter.castGroup(), name)) return found;
+    } else if (parameter.getName() == name) {
+      return &parameter;
+    }
+  }
+  return nullptr;
+}
+
+using ScenarioFactory = std::function<std::unique_ptr<Scenario>(const std::string& input)>;
+
+// Scenarios by command-line name; input is the --input argument.
+inline const std::map<std::string, ScenarioFactory>& getScenarios() {
+  static const std::map<std::string, ScenarioFactory> scenarios {
+    { "fluid", [](const std::string&) { return std::make_unique<FluidScenario>(); } },
+    { "fluid-replay", [](const std::string& input) { return std::make_unique<FluidReplayScenario>(input); } },
+    { "fluid-fused-check", [](const std::string&) {
+      return std::make_unique<FluidCheckScenario>([](FluidSimulation& simulation) {
+        simulation.getParameterGroup().getBool("Fused Passes").set(true);
+      });
+    } },
+    { "fluid-direct-check", [](const std::string&) {
+      return std::make_unique<FluidCheckScenario>([](FluidSimulation& simulation) {
+        simulation.setPassMode(Shader::PassMode::Direct);
+      });
+    } },
+    { "smear", [](const std::string&) { return std::make_unique<SmearScenario>(); } },
+    { "softcircle", [](const std::string&) { return std::make_unique<SoftCircleScenario>(); } },
+    { "flowfield", [](const std::string&) { return std::make_unique<FlowFieldScenario>(); } },
+  };
+  return scenarios;
+}
@@ -0,0 +1,107 @@
+#include "ofMain.h"
+#include "ofApp.h"
+#include "HeadlessEglWindow.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+namespace {
+
+void printUsage() {
+  std::string names;
+  for (const auto& [name, factory] : getScenarios()) names += (names.empty() ? "" : "|") + name;
+  std::printf("usage: example_headless <%s> [options]\n"
+              "  --frames N              frames to time (60)\n"
+              "  --warmup N              untimed frames first (0)\n"
+              "  --size WxH              (256x256)\n"
+              "  --seed N                (1)\n"
+              "  --input PATH            scenario input, e.g. the fluid-replay event log\n"
+              "  --golden PATH           compare the result with a golden image\n"
+              "  --write-golden PATH     save the result as a golden image\n"
+              "  --tolerance X           absolute error allowed per channel (1e-4)\n"
+              "  --relative-tolerance X  plus this fraction of the golden value (0)\n"
+              "  --max-bad-fraction X    fraction of channels allowed out of tolerance (0)\n"
+              "  --reference-tolerance X max abs error against a -check scenario's reference (1e-4)\n"
+              "  --pass-mode fbo|direct  how fullscreen passes are issued (the scenario's default)\n"
+              "  --set NAME=VALUE        set a scenario parameter after setup; repeatable\n"
+              "  --trace PATH            Chrome trace of the timed frames (OFXRENDERER_TRACING builds)\n",
+              names.c_str());
+}
+
+std::string absolutePath(const std::string& path) {
+  return path.empty() ? path : std::filesystem::absolute(path).string();
+}
+
+bool parseOptions(int argc, char* argv[], HarnessOptions& options) {
+  if (argc < 2 || getScenarios().count(argv[1]) == 0) return false;
+  options.scenario = argv[1];
+  for (int i = 2; i < argc; ++i) {
+    const std::string option = argv[i];
+    if (i + 1 >= argc) return false;
+    const std::string value = argv[++i];
+    if (option == "--frames") {
+      options.frames = std::max(1, ofToInt(value));
+    } else if (option == "--warmup") {
+      options.warmupFrames = std::max(0, ofToInt(value));
+    } else if (option == "--size") {
+      if (std::sscanf(value.c_str(), "%dx%d", &options.width, &options.height) != 2
+          || options.width <= 0 || options.height <= 0) return false;
+    } else if (option == "--seed") {
+      options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    } else if (option == "--input") {
+      options.input = absolutePath(value);
+    } else if (option == "--golden") {
+      options.goldenPath = absolutePath(value);
+    } else if (option == "--write-golden") {
+      options.writeGoldenPath = absolutePath(value);
+    } else if (option == "--trace") {
+      options.tracePath = absolutePath(value);
+    } else if (option == "--tolerance") {
+      options.absoluteTolerance = ofToFloat(value);
+    } else if (option == "--relative-tolerance") {
+      options.relativeTolerance = ofToFloat(value);
+    } else if (option == "--max-bad-fraction") {
+      options.maxBadFraction = ofToFloat(value);
+    } else if (option == "--reference-tolerance") {
+      options.referenceTolerance = ofToFloat(value);
+    } else if (option == "--pass-mode") {
+      if (value == "fbo") {
+        options.passMode = Shader::PassMode::Fbo;
+      } else if (value == "direct") {
+        options.passMode = Shader::PassMode::Direct;
+      } else {
+        return false;
+      }
+    } else if (option == "--set") {
+      const size_t equals = value.find('=');
+      if (equals == std::string::npos || equals == 0) return false;
+      options.parameterOverrides.emplace_back(value.substr(0, equals), value.substr(equals + 1));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+//========================================================================
+int main(int argc, char* argv[]){
+  HarnessOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage();
+    return 2;
+  }
+
+  ofInit();
+  ofGLWindowSettings settings;
+  settings.setGLVersion(4, 1);
+  settings.setSize(options.width, options.height);
+  auto window = std::make_shared<HeadlessEglWindow>();
+  ofGetMainLoop()->addWindow(window);
+  window->setup(settings);
+
+  ofRunApp(window, std::make_shared<ofApp>(options));
+  return ofRunMainLoop();
+}
@@ -0,0 +1,153 @@
+#include "ofApp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "GoldenImage.h"
+#include "TraceRecorder.h"
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+  ofSetFrameRate(0); // as fast as the GPU goes
+  ofSetBackgroundAuto(false); // there is no default framebuffer to clear
+  ofDisableArbTex();
+
+  scenario = getScenarios().at(options.scenario)(options.input);
+  if (options.passMode && !scenario->setPassMode(*options.passMode)) {
+    ofLogError("ofApp") << options.scenario << " has no pass mode to set";
+    done = true;
+    ofExit(2);
+    return;
+  }
+  if (!scenario->setup(options.width, options.height, options.seed)) {
+    ofLogError("ofApp") << "can't set up " << options.scenario;
+    done = true;
+    ofExit(2);
+    return;
+  }
+  if (!applyOverrides()) {
+    done = true;
+    ofExit(2);
+    return;
+  }
+  glFinish();
+  std::printf("%s %dx%d, %d frames (+%d warmup), seed %u\n", options.scenario.c_str(), options.width,
+              options.height, options.frames, options.warmupFrames, options.seed);
+}
+
+//--------------------------------------------------------------
+bool ofApp::applyOverrides(){
+  if (options.parameterOverrides.empty()) return true;
+  const std::vector<ofParameterGroup*> groups = scenario->getParameters();
+  if (groups.empty()) {
+    ofLogError("ofApp") << options.scenario << " has no parameters to set";
+    return false;
+  }
+  for (const auto& [name, value] : options.parameterOverrides) {
+    ofAbstractParameter* parameter = nullptr;
+    for (ofParameterGroup* group : groups) {
+      ofAbstractParameter* found = findParameter(*group, name);
+      if (!found) continue;
+      found->fromString(value);
+      parameter = found;
+    }
+    if (!parameter) {
+      ofLogError("ofApp") << options.scenario << " has no parameter '" << name << "'";
+      return false;
+    }
+    std::printf("%s = %s\n", name.c_str(), parameter->toString().c_str());
+  }
+  return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+  if (done) return;
+  if (frame == options.warmupFrames && !options.tracePath.empty()) {
+#ifdef OFXRENDERER_TRACING
+    OFXRENDERER_TRACE_START(options.tracePath, options.frames);
+#else
+    ofLogWarning("ofApp") << "--trace needs a build with OFXRENDERER_TRACING defined";
+#endif
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  scenario->frame(frame);
+  glFinish();
+  const auto end = std::chrono::steady_clock::now();
+  if (frame >= options.warmupFrames) frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+  ++frame;
+  if (frame >= options.warmupFrames + options.frames || scenario->isFinished()) finish();
+}
+
+//--------------------------------------------------------------
+void ofApp::finish(){
+  done = true;
+  OFXRENDERER_TRACE_STOP();
+  if (scenario->isFinished()) std::printf("input ended after %d frames\n", frame - 1);
+  printTimings();
+
+  const GoldenImage image = GoldenImage::read(scenario->getResult());
+  int status = 0;
+  if (!options.writeGoldenPath.empty()) {
+    if (image.save(options.writeGoldenPath)) {
+      std::printf("wrote golden %s\n", options.writeGoldenPath.c_str());
+    } else {
+      status = 2;
+    }
+  }
+
+  if (!options.goldenPath.empty()) {
+    GoldenImage golden;
+    if (!golden.load(options.goldenPath)) {
+      status = 2;
+    } else if (!report("golden " + options.goldenPath, image, golden, options.absoluteTolerance,
+                       options.relativeTolerance, options.maxBadFraction) && status == 0) {
+      status = 1;
+    }
+  }
+
+  // Scenarios that run two paths side by side must agree everywhere within the reference tolerance
+  if (const ofFbo* reference = scenario->getReference()) {
+    if (!report("reference", image, GoldenImage::read(*reference), options.referenceTolerance, 0.0f, 0.0f)
+        && status == 0) {
+      status = 1;
+    }
+  }
+
+  std::fflush(stdout);
+  ofExit(status);
+}
+
+//--------------------------------------------------------------
+bool ofApp::report(const std::string& label, const GoldenImage& image, const GoldenImage& expected,
+                   float absoluteTolerance, float relativeTolerance, float maxBadFraction) const {
+  const auto comparison = GoldenComparison::compare(image, expected, absoluteTolerance, relativeTolerance);
+  if (!comparison.sizeMatches) {
+    std::printf("%s: FAIL, size %ux%u, expected %ux%u\n", label.c_str(),
+                image.width, image.height, expected.width, expected.height);
+    return false;
+  }
+  std::printf("%s: %s, max abs error %g, rms %g, %zu of %zu channels out of tolerance",
+              label.c_str(), comparison.passes(maxBadFraction) ? "pass" : "FAIL",
+              comparison.maxAbsoluteError, comparison.rmsError, comparison.badChannels, comparison.channels);
+  if (comparison.badChannels > 0) {
+    std::printf(" (first at %zu,%zu)", comparison.firstBadTexel % image.width, comparison.firstBadTexel / image.width);
+  }
+  std::printf("\n");
+  return comparison.passes(maxBadFraction);
+}
+
+//--------------------------------------------------------------
+void ofApp::printTimings() const {
+  if (frameMs.empty()) return;
+  std::vector<double> sorted = frameMs;
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0.0;
+  for (double ms : sorted) sum += ms;
+  const auto percentile = [&](size_t percent) { return sorted[std::min(sorted.size() - 1, (sorted.size() * percent) / 100)]; };
+  std::printf("frame ms: mean %.3f, min %.3f, median %.3f, p95 %.3f, max %.3f over %zu frames\n",
+              sum / sorted.size(), sorted.front(), percentile(50), percentile(95), sorted.back(), sorted.size());
+}
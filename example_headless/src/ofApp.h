@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ofMain.h"
+#include "GoldenImage.h"
+#include "Scenarios.h"
+
+struct HarnessOptions {
+  std::string scenario;
+  std::string input;           // scenario input, e.g. the fluid-replay event log
+  int width = 256;
+  int height = 256;
+  int frames = 60;
+  int warmupFrames = 0;        // run first and left out of the timings
+  uint32_t seed = 1;
+  std::string goldenPath;      // compare against this golden image
+  std::string writeGoldenPath; // save the result as a golden image
+  std::string tracePath;       // Chrome trace of the timed frames (OFXRENDERER_TRACING builds)
+  std::optional<Shader::PassMode> passMode;
+  std::vector<std::pair<std::string, std::string>> parameterOverrides; // name, value; applied in order
+  float absoluteTolerance = 1.0e-4f;
+  float relativeTolerance = 0.0f;
+  float maxBadFraction = 0.0f;
+  float referenceTolerance = 1.0e-4f; // max abs error against the scenario's reference, if it has one
+};
+
+// Runs one scenario for a fixed number of frames, timing each frame to completion on the GPU,
+// then reads the result back and checks it against a golden image. Exits with 0 on success,
+// 1 if the result drifted past the tolerances and 2 if the run itself failed.
+class ofApp : public ofBaseApp {
+public:
+  explicit ofApp(const HarnessOptions& options_) : options(options_) {}
+
+  void setup() override;
+  void update() override;
+
+private:
+  bool applyOverrides();
+  void finish();
+  // Prints how image compares with expected; true if it passes.
+  bool report(const std::string& label, const GoldenImage& image, const GoldenImage& expected,
+              float absoluteTolerance, float relativeTolerance, float maxBadFraction) const;
+  void printTimings() const;
+
+  HarnessOptions options;
+  std::unique_ptr<Scenario> scenario;
+  int frame = 0;
+  bool done = false;
+  std::vector<double> frameMs;
+};
@@ -1,20 +1,5 @@
 #include "ofApp.h"
 
-
-static ofFloatPixels makePerlin2DNoise(int w, int h, float scale, float z) {
-  ofFloatPixels pixels;
-  pixels.allocate(w, h, OF_PIXELS_RGB);
-  for (int y = 0; y < h; ++y) {
-    for (int x = 0; x < w; ++x) {
-      float n1 = ofNoise(x * scale, y * scale, z);
-      float n2 = ofNoise((x+5000) * scale, (y+5000) * scale, z);
-      pixels.setColor(x, y, ofFloatColor(n1, n2, 0.0, 0.0));
-    }
-  }
-  return pixels;
-}
-
-
 //--------------------------------------------------------------
 void ofApp::setup(){
   ofEnableAlphaBlending();
@@ -25,8 +10,9 @@ void ofApp::setup(){
 
   smearShader.load();
   
-  field1Texture.allocate(fieldWidth, fieldHeight, GL_RG16F);
-  field2Texture.allocate(fieldWidth, fieldHeight, GL_RG16F);
+  field1Renderer.load();
+  field1Renderer.allocate(fieldWidth, fieldHeight);
+  field2Uploader.allocate(fieldWidth, fieldHeight, 2);
 
   parameters.add(alphaParameter);
   parameters.add(mixNewParameter);
@@ -35,15 +21,23 @@ void ofApp::setup(){
   parameters.add(field1BiasParameter);
   parameters.add(field2MultiplierParameter);
   parameters.add(field2BiasParameter);
+  parameters.add(field1Renderer.getParameterGroup());
   gui.setup(parameters);
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
-  ofFloatPixels pixels1 = makePerlin2DNoise(fieldWidth, fieldHeight, 0.005, ofGetElapsedTimef()*0.1);
-  field1Texture.loadData(pixels1);
-  ofFloatPixels pixels2 = makePerlin2DNoise(fieldWidth, fieldHeight, 0.02, -1000.0 + ofGetElapsedTimef()*0.1);
-  field2Texture.loadData(pixels2);
+  // Field 1 is generated on the GPU, field 2 on the CPU and streamed up
+  field1Renderer.update(ofGetElapsedTimef());
+  FlowFieldNoise::Settings noiseSettings;
+  noiseSettings.octaves = 2;
+  noiseSettings.scale = 0.02;
+  noiseSettings.time = -1000.0 + ofGetElapsedTimef()*0.1;
+  noiseSettings.curl = true; // divergence-free
+  flowFieldNoise.generate(fieldWidth, fieldHeight, noiseSettings, field2Data);
+  field2Uploader.upload(field2Data);
+  ofTexture& field1Texture = field1Renderer.getTexture();
+  ofTexture& field2Texture = field2Uploader.getTexture();
 
   fbo.getSource().begin();
   {
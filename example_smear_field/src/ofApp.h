@@ -2,6 +2,9 @@
 
 #include "ofMain.h"
 #include "SmearShader.h"
+#include "StreamingTextureUploader.h"
+#include "FlowFieldNoise.h"
+#include "FlowFieldRenderer.h"
 #include "ofxGui.h"
 
 class ofApp : public ofBaseApp{
@@ -28,7 +31,10 @@ public:
 private:
   int fieldWidth = 200;
   int fieldHeight = 200;
-  ofTexture field1Texture, field2Texture;
+  FlowFieldNoise flowFieldNoise;
+  FlowFieldRenderer field1Renderer;
+  std::vector<float> field2Data;
+  StreamingTextureUploader field2Uploader;
 
   SmearShader smearShader;
   
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "ofFbo.h"
+#include "DownsampleShader.h"
+#include "PboReadback.h"
+#include "HalfFloat.h"
+
+// Streams a float field (e.g. FluidSimulation::getFlowVelocitiesFbo().getSource()) back to the
+// CPU every frame without stalling: read() queues the transfer into a 3-buffer PboReadback ring
+// and update() collects the newest one the GPU has finished, usually a frame or two late.
+// The field can be box-filtered down on the GPU first, and transferred as half floats to halve
+// the bandwidth (GL packs them); either way getFrame() holds floats, converted on the CPU.
+//
+// Frame data is row-major in GL row order (row 0 is texture row 0), `channels` floats per texel.
+class FieldReadback {
+
+public:
+  enum class Precision {
+    Float32,
+    Float16,
+  };
+
+  struct Frame {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    uint64_t tag = 0; // as passed to read()
+    std::vector<float> data;
+  };
+
+  void load() {
+    downsampleShader.load();
+  }
+
+  void setPassMode(Shader::PassMode passMode) { downsampleShader.setPassMode(passMode); }
+
+  // channels: the first 1..4 channels of the field to read back (2 for velocities).
+  // downsampleFactor: 1 reads the field at full size, n reads ceil(w/n) x ceil(h/n) block means.
+  void setup(int channels_, int downsampleFactor_ = 1, Precision precision_ = Precision::Float32) {
+    channels = std::clamp(channels_, 1, 4);
+    downsampleFactor = std::max(1, downsampleFactor_);
+    precision = precision_;
+    sourceWidth = 0; // reallocate on the next read
+  }
+
+  // Whether read() would queue a readback now; false while every buffer of the ring is still in
+  // flight. Lets a caller skip the work that produces the field, too.
+  bool canRead() const { return readback.hasFreeBuffer(); }
+
+  // Queues a readback of field. Issues no passes and returns false (dropping the request) if
+  // every buffer of the ring is still in flight.
+  bool read(const ofFbo& field, uint64_t tag = 0) {
+    const int width = static_cast<int>(field.getWidth());
+    const int height = static_cast<int>(field.getHeight());
+    if (width <= 0 || height <= 0) return false;
+    if (!canRead()) return false;
+
+    const ofFbo* source = &field;
+    if (downsampleFactor > 1) {
+      allocateIfNeeded(width, height);
+      downsampleShader.render(downsampled, field.getTexture(), downsampleFactor);
+      source = &downsampled;
+    }
+
+    const int readWidth = static_cast<int>(source->getWidth());
+    const int readHeight = static_cast<int>(source->getHeight());
+    const size_t componentBytes = precision == Precision::Float16 ? sizeof(uint16_t) : sizeof(float);
+    const size_t bytes = static_cast<size_t>(readWidth) * readHeight * channels * componentBytes;
+    const GLenum type = precision == Precision::Float16 ? GL_HALF_FLOAT : GL_FLOAT;
+    if (!readback.read(*source, 0, 0, readWidth, readHeight, getFormat(), type, bytes, nextSequence)) return false;
+
+    pending.push_back({ nextSequence++, tag, readWidth, readHeight, channels, precision });
+    return true;
+  }
+
+  // Collects the newest finished readback, if any. Returns true when getFrame() was updated.
+  bool update() {
+    uint64_t sequence = 0;
+    if (!readback.fetch(readbackData, &sequence)) return false;
+
+    // Reads are fetched in order, so any request older than this one was dropped by the ring.
+    Request request;
+    bool found = false;
+    while (!pending.empty()) {
+      request = pending.front();
+      pending.erase(pending.begin());
+      if (request.sequence == sequence) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) return false;
+
+    frame.width = request.width;
+    frame.height = request.height;
+    frame.channels = request.channels;
+    frame.tag = request.tag;
+    const size_t count = static_cast<size_t>(request.width) * request.height * request.channels;
+    frame.data.resize(count);
+    if (request.precision == Precision::Float16) {
+      HalfFloat::toFloats({ reinterpret_cast<const uint16_t*>(readbackData.data()), count }, frame.data);
+    } else {
+      std::memcpy(frame.data.data(), readbackData.data(), count * sizeof(float));
+    }
+    hasFrame_ = true;
+    return true;
+  }
+
+  bool hasFrame() const { return hasFrame_; }
+  const Frame& getFrame() const { return frame; }
+
+  // Channel c of texel (x, y) of the latest frame, in its (possibly downsampled) coordinates.
+  float get(int x, int y, int c = 0) const {
+    return frame.data[(static_cast<size_t>(y) * frame.width + x) * frame.channels + c];
+  }
+
+private:
+  struct Request {
+    uint64_t sequence = 0;
+    uint64_t tag = 0;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    Precision precision = Precision::Float32;
+  };
+
+  GLenum getFormat() const {
+    switch (channels) {
+      case 1: return GL_RED;
+      case 2: return GL_RG;
+      case 3: return GL_RGB;
+      default: return GL_RGBA;
+    }
+  }
+
+  void allocateIfNeeded(int width, int height) {
+    if (width == sourceWidth && height == sourceHeight) return;
+    sourceWidth = width;
+    sourceHeight = height;
+
+    ofFboSettings settings;
+    settings.width = (width + downsampleFactor - 1) / downsampleFactor;
+    settings.height = (height + downsampleFactor - 1) / downsampleFactor;
+    settings.internalformat = precision == Precision::Float16 ? GL_RGBA16F : GL_RGBA32F;
+    settings.useDepth = false;
+    settings.useStencil = false;
+    settings.textureTarget = GL_TEXTURE_2D;
+    settings.minFilter = GL_NEAREST;
+    settings.maxFilter = GL_NEAREST;
+    downsampled.allocate(settings);
+  }
+
+  DownsampleShader downsampleShader;
+  ofFbo downsampled;
+  int sourceWidth = 0;
+  int sourceHeight = 0;
+  int channels = 4;
+  int downsampleFactor = 1;
+  Precision precision = Precision::Float32;
+  PboReadback readback { 3 };
+  std::vector<Request> pending;
+  uint64_t nextSequence = 0;
+  std::vector<uint8_t> readbackData;
+  Frame frame;
+  bool hasFrame_ = false;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "ofFbo.h"
+#include "ReduceShader.h"
+#include "PboReadback.h"
+
+// Reduces a field texture to its max and RMS magnitude on the GPU (a chain of 4x4 ReduceShader
+// passes down to one texel) and reads the result back through a PboReadback ring, so callers get
+// statistics a frame or two late instead of stalling the pipeline.
+class FieldReduction {
+
+public:
+  using Input = ReduceShader::Input;
+
+  struct Result {
+    float max = 0.0f;
+    float rms = 0.0f;
+    uint64_t tag = 0; // as passed to reduce()
+  };
+
+  void load() {
+    reduceShader.load();
+  }
+
+  void setPassMode(Shader::PassMode passMode) { reduceShader.setPassMode(passMode); }
+
+  // Whether reduce() would queue a reduction now; false while the readback ring is full. Lets a
+  // caller skip the work that produces the field, too.
+  bool canReduce() const { return readback.hasFreeBuffer(); }
+
+  // Queues a reduction of field and returns true. Issues no passes and returns false if the
+  // readback ring is still full.
+  bool reduce(const ofTexture& field, Input input, uint64_t tag = 0) {
+    const int width = static_cast<int>(field.getWidth());
+    const int height = static_cast<int>(field.getHeight());
+    if (width <= 0 || height <= 0) return false;
+    if (!canReduce()) return false;
+    allocateIfNeeded(width, height);
+
+    const ofTexture* source = &field;
+    Input sourceInput = input;
+    for (auto& level : levels) {
+      reduceShader.render(level, *source, sourceInput);
+      source = &level.getTexture();
+      sourceInput = Input::Reduced;
+    }
+
+    constexpr size_t BYTES = 2 * sizeof(float);
+    readback.read(levels.back(), 0, 0, 1, 1, GL_RG, GL_FLOAT, BYTES, tag);
+    sampleCount = width * height;
+    return true;
+  }
+
+  // Collects the newest finished reduction, if any. Returns true when `result` was updated.
+  bool update() {
+    uint64_t tag = 0;
+    if (!readback.fetch(readbackData, &tag)) return false;
+    float values[2];
+    std::copy_n(reinterpret_cast<const float*>(readbackData.data()), 2, values);
+    result.max = values[0];
+    result.rms = std::sqrt(values[1] / static_cast<float>(std::max(1, sampleCount)));
+    result.tag = tag;
+    hasResult_ = true;
+    return true;
+  }
+
+  bool hasResult() const { return hasResult_; }
+  const Result& getResult() const { return result; }
+
+private:
+  void allocateIfNeeded(int width, int height) {
+    if (width == sourceWidth && height == sourceHeight) return;
+    sourceWidth = width;
+    sourceHeight = height;
+
+    levels.clear();
+    int w = width;
+    int h = height;
+    do {
+      w = (w + ReduceShader::FACTOR - 1) / ReduceShader::FACTOR;
+      h = (h + ReduceShader::FACTOR - 1) / ReduceShader::FACTOR;
+      ofFboSettings settings;
+      settings.width = w;
+      settings.height = h;
+      settings.internalformat = GL_RG32F;
+      settings.useDepth = false;
+      settings.useStencil = false;
+      settings.textureTarget = GL_TEXTURE_2D;
+      settings.minFilter = GL_NEAREST;
+      settings.maxFilter = GL_NEAREST;
+      levels.emplace_back();
+      levels.back().allocate(settings);
+    } while (w > 1 || h > 1);
+  }
+
+  ReduceShader reduceShader;
+  std::vector<ofFbo> levels;
+  int sourceWidth = 0;
+  int sourceHeight = 0;
+  int sampleCount = 1;
+  PboReadback readback;
+  std::vector<uint8_t> readbackData;
+  Result result;
+  bool hasResult_ = false;
+};
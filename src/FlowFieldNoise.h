@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ofVectorMath.h"
+
+// Generates 2-channel flow fields for SmearShader's field1Texture/field2Texture (e.g. through a
+// StreamingTextureUploader) on the CPU: fractal gradient noise over (x, y, time), evaluated
+// LANES pixels at a time in branch-free structure-of-arrays loops the compiler vectorises, with
+// rows split across a persistent worker pool. Output buffers are reused between calls.
+//
+// Output is interleaved RG in GL row order, centred on 0.5 like ofNoise (so SmearShader's usual
+// -0.5 bias applies). Plain mode writes two decorrelated noise channels; curl mode writes the
+// curl of a single noise potential, a divergence-free field, at the cost of one noise channel.
+class FlowFieldNoise {
+
+public:
+  static constexpr int LANES = 8;
+
+  struct Settings {
+    float scale = 0.005f;               // noise units per pixel
+    float time = 0.0f;                  // third noise coordinate
+    int octaves = 2;
+    float lacunarity = 2.0f;
+    float gain = 0.5f;
+    bool curl = false;
+    float curlAmount = 0.5f;            // curl mode: output = 0.5 + curlAmount * curl (noise units)
+    glm::vec2 secondChannelOffset { 97.3f, 131.9f }; // plain mode: G samples noise here
+  };
+
+  // threadCount includes the calling thread.
+  explicit FlowFieldNoise(unsigned threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+    for (unsigned i = 1; i < threadCount; ++i) {
+      workers.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ~FlowFieldNoise() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+  }
+
+  FlowFieldNoise(const FlowFieldNoise&) = delete;
+  FlowFieldNoise& operator=(const FlowFieldNoise&) = delete;
+
+  // Fills field with width * height * 2 floats, reusing its capacity.
+  void generate(int width, int height, const Settings& settings, std::vector<float>& field) {
+    field.resize(static_cast<size_t>(width) * height * 2);
+    float* out = field.data();
+    const std::function<void(int, int)> rows = [&](int y0, int y1) {
+      for (int y = y0; y < y1; ++y) generateRow(out + static_cast<size_t>(y) * width * 2, width, y, settings);
+    };
+    parallelRows(height, rows);
+  }
+
+  // As above into one of a small pool of internal buffers, so the previous few results stay
+  // valid while they are uploaded.
+  const std::vector<float>& generate(int width, int height, const Settings& settings) {
+    std::vector<float>& field = buffers[nextBuffer];
+    nextBuffer = (nextBuffer + 1) % buffers.size();
+    generate(width, height, settings, field);
+    return field;
+  }
+
+  // Fractal noise in [-1, 1] (roughly) at p, with its x and y derivatives in noise units.
+  static float fractalNoise(glm::vec3 p, int octaves, float lacunarity, float gain, float& dx, float& dy) {
+    float value = 0.0f;
+    float amplitude = 1.0f;
+    float frequency = 1.0f;
+    float norm = 0.0f;
+    dx = dy = 0.0f;
+    for (int octave = 0; octave < octaves; ++octave) {
+      float ndx, ndy;
+      value += amplitude * noise(p.x * frequency, p.y * frequency, p.z * frequency, ndx, ndy);
+      dx += amplitude * frequency * ndx;
+      dy += amplitude * frequency * ndy;
+      norm += amplitude;
+      amplitude *= gain;
+      frequency *= lacunarity;
+    }
+    const float scale = norm > 0.0f ? 1.0f / norm : 0.0f;
+    dx *= scale;
+    dy *= scale;
+    return value * scale;
+  }
+
+  // Improved-Perlin style gradient noise with analytic x and y derivatives. Integer hashing
+  // instead of a permutation table keeps it free of gathers and branches.
+  static float noise(float x, float y, float z, float& dx, float& dy) {
+    float value;
+    noise(&x, y, z, 1, &value, &dx, &dy);
+    return value;
+  }
+
+  // As above at count points along x, sharing y and z. The per-point body is written out with
+  // no branches or inner loops, so the loop over points vectorises.
+  static void noise(const float* x, float y, float z, int count, float* value, float* dx, float* dy) {
+    const int32_t iy = fastFloor(y);
+    const int32_t iz = fastFloor(z);
+    const float fy = y - static_cast<float>(iy);
+    const float fz = z - static_cast<float>(iz);
+    const float v = fade(fy), w = fade(fz);
+    const float dv = fadeDerivative(fy);
+    for (int lane = 0; lane < count; ++lane) {
+      const int32_t ix = fastFloor(x[lane]);
+      const float fx = x[lane] - static_cast<float>(ix);
+      const float u = fade(fx);
+      const float du = fadeDerivative(fx);
+
+      float gx000, gx100, gx010, gx110, gx001, gx101, gx011, gx111;
+      float gy000, gy100, gy010, gy110, gy001, gy101, gy011, gy111;
+      const float d000 = corner(ix, iy, iz, fx, fy, fz, gx000, gy000);
+      const float d100 = corner(ix + 1, iy, iz, fx - 1.0f, fy, fz, gx100, gy100);
+      const float d010 = corner(ix, iy + 1, iz, fx, fy - 1.0f, fz, gx010, gy010);
+      const float d110 = corner(ix + 1, iy + 1, iz, fx - 1.0f, fy - 1.0f, fz, gx110, gy110);
+      const float d001 = corner(ix, iy, iz + 1, fx, fy, fz - 1.0f, gx001, gy001);
+      const float d101 = corner(ix + 1, iy, iz + 1, fx - 1.0f, fy, fz - 1.0f, gx101, gy101);
+      const float d011 = corner(ix, iy + 1, iz + 1, fx, fy - 1.0f, fz - 1.0f, gx011, gy011);
+      const float d111 = corner(ix + 1, iy + 1, iz + 1, fx - 1.0f, fy - 1.0f, fz - 1.0f, gx111, gy111);
+
+      // Trilinear blend of the corner values and, by the product rule, of their derivatives.
+      const float x00 = d000 + u * (d100 - d000), x10 = d010 + u * (d110 - d010);
+      const float x01 = d001 + u * (d101 - d001), x11 = d011 + u * (d111 - d011);
+      const float y0 = x00 + v * (x10 - x00), y1 = x01 + v * (x11 - x01);
+
+      const float gx00 = gx000 + u * (gx100 - gx000) + du * (d100 - d000);
+      const float gx10 = gx010 + u * (gx110 - gx010) + du * (d110 - d010);
+      const float gx01 = gx001 + u * (gx101 - gx001) + du * (d101 - d001);
+      const float gx11 = gx011 + u * (gx111 - gx011) + du * (d111 - d011);
+      const float dx0 = gx00 + v * (gx10 - gx00), dx1 = gx01 + v * (gx11 - gx01);
+
+      const float gy00 = gy000 + u * (gy100 - gy000), gy10 = gy010 + u * (gy110 - gy010);
+      const float gy01 = gy001 + u * (gy101 - gy001), gy11 = gy011 + u * (gy111 - gy011);
+      const float dy0 = gy00 + v * (gy10 - gy00) + dv * (x10 - x00);
+      const float dy1 = gy01 + v * (gy11 - gy01) + dv * (x11 - x01);
+
+      value[lane] = y0 + w * (y1 - y0);
+      dx[lane] = dx0 + w * (dx1 - dx0);
+      dy[lane] = dy0 + w * (dy1 - dy0);
+    }
+  }
+
+private:
+  static constexpr int ROWS_PER_TASK = 4;
+
+  // std::floor is a libm call the vectoriser won't touch; truncate and correct instead.
+  static inline int32_t fastFloor(float x) {
+    const int32_t i = static_cast<int32_t>(x);
+    return i - (x < static_cast<float>(i) ? 1 : 0);
+  }
+
+  static inline float fade(float t) { return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); }
+  static inline float fadeDerivative(float t) { return 30.0f * t * t * (t * (t - 2.0f) + 1.0f); }
+
+  static inline uint32_t hash(int32_t x, int32_t y, int32_t z) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x8da6b343u
+      ^ static_cast<uint32_t>(y) * 0xd8163841u
+      ^ static_cast<uint32_t>(z) * 0xcb1ab31fu;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return h;
+  }
+
+  // The 12 cube-edge gradients of improved Perlin noise (4 repeated), assembled from the hash
+  // bits with integer masks: selecting with ?: or bool-to-float products leaves branches that
+  // stop the lane loop vectorising.
+  static inline void gradient(uint32_t h, float& gx, float& gy, float& gz) {
+    const uint32_t g = h & 15u;
+    const uint32_t u = 0x3f800000u | (g & 1u) << 31; // 1.0f, negative if bit 0
+    const uint32_t v = 0x3f800000u | (g & 2u) << 30; // 1.0f, negative if bit 1
+    const uint32_t uIsX = 0u - (~g >> 3 & 1u);                 // g < 8
+    const uint32_t vIsY = 0u - (~(g >> 2 | g >> 3) & 1u);      // g < 4
+    const uint32_t vIsX = 0u - (g >> 3 & g >> 2 & ~g & 1u);    // g == 12 || g == 14
+    gx = asFloat(u & uIsX) + asFloat(v & vIsX);
+    gy = asFloat(u & ~uIsX) + asFloat(v & vIsY);
+    gz = asFloat(v & ~(vIsY | vIsX));
+  }
+
+  static inline float asFloat(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+
+  // Gradient dot offset at one lattice corner, with the gradient's x and y.
+  static inline float corner(int32_t ix, int32_t iy, int32_t iz, float fx, float fy, float fz, float& gx, float& gy) {
+    float gz;
+    gradient(hash(ix, iy, iz), gx, gy, gz);
+    return gx * fx + gy * fy + gz * fz;
+  }
+
+  // Fractal noise for LANES consecutive pixels of one row, octave by octave.
+  static void fractalNoiseLanes(const float* x, float y, float z, const Settings& settings,
+                                float* value, float* dx, float* dy) {
+    float norm = 0.0f;
+    float amplitude = 1.0f;
+    float frequency = 1.0f;
+    for (int lane = 0; lane < LANES; ++lane) value[lane] = dx[lane] = dy[lane] = 0.0f;
+    alignas(32) float fx[LANES], nValue[LANES], nDx[LANES], nDy[LANES];
+    for (int octave = 0; octave < settings.octaves; ++octave) {
+      for (int lane = 0; lane < LANES; ++lane) fx[lane] = x[lane] * frequency;
+      noise(fx, y * frequency, z * frequency, LANES, nValue, nDx, nDy);
+      const float dScale = amplitude * frequency;
+      for (int lane = 0; lane < LANES; ++lane) {
+        value[lane] += amplitude * nValue[lane];
+        dx[lane] += dScale * nDx[lane];
+        dy[lane] += dScale * nDy[lane];
+      }
+      norm += amplitude;
+      amplitude *= settings.gain;
+      frequency *= settings.lacunarity;
+    }
+    const float scale = norm > 0.0f ? 1.0f / norm : 0.0f;
+    for (int lane = 0; lane < LANES; ++lane) {
+      value[lane] *= scale;
+      dx[lane] *= scale;
+      dy[lane] *= scale;
+    }
+  }
+
+  static void generateRow(float* out, int width, int row, const Settings& settings) {
+    alignas(32) float x[LANES], value[LANES], dx[LANES], dy[LANES];
+    alignas(32) float x2[LANES], value2[LANES], dx2[LANES], dy2[LANES];
+    const float y = row * settings.scale;
+    for (int x0 = 0; x0 < width; x0 += LANES) {
+      for (int lane = 0; lane < LANES; ++lane) x[lane] = (x0 + lane) * settings.scale;
+      fractalNoiseLanes(x, y, settings.time, settings, value, dx, dy);
+
+      const int count = std::min(LANES, width - x0);
+      float* texel = out + static_cast<size_t>(x0) * 2;
+      if (settings.curl) {
+        for (int lane = 0; lane < count; ++lane) {
+          texel[lane * 2] = 0.5f + settings.curlAmount * dy[lane];
+          texel[lane * 2 + 1] = 0.5f - settings.curlAmount * dx[lane];
+        }
+      } else {
+        for (int lane = 0; lane < LANES; ++lane) x2[lane] = x[lane] + settings.secondChannelOffset.x;
+        fractalNoiseLanes(x2, y + settings.secondChannelOffset.y, settings.time, settings, value2, dx2, dy2);
+        for (int lane = 0; lane < count; ++lane) {
+          texel[lane * 2] = 0.5f + 0.5f * value[lane];
+          texel[lane * 2 + 1] = 0.5f + 0.5f * value2[lane];
+        }
+      }
+    }
+  }
+
+  // Runs fn(firstRow, endRow) over [0, rows) in ROWS_PER_TASK chunks on the workers and the
+  // calling thread, returning when all rows are done.
+  void parallelRows(int rows, const std::function<void(int, int)>& fn) {
+    if (workers.empty()) {
+      fn(0, rows);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &fn;
+      jobRows = rows;
+      nextRow = 0;
+      busyWorkers = workers.size();
+      ++generation;
+    }
+    wake.notify_all();
+    work(fn, rows);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+  }
+
+  void work(const std::function<void(int, int)>& fn, int rows) {
+    while (true) {
+      const int first = nextRow.fetch_add(ROWS_PER_TASK);
+      if (first >= rows) break;
+      fn(first, std::min(first + ROWS_PER_TASK, rows));
+    }
+  }
+
+  void workerLoop() {
+    uint64_t seenGeneration = 0;
+    while (true) {
+      const std::function<void(int, int)>* fn;
+      int rows;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+        if (stopping) return;
+        seenGeneration = generation;
+        fn = job;
+        rows = jobRows;
+      }
+      work(*fn, rows);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) done.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const std::function<void(int, int)>* job = nullptr;
+  int jobRows = 0;
+  std::atomic<int> nextRow { 0 };
+  size_t busyWorkers = 0;
+  uint64_t generation = 0;
+  bool stopping = false;
+
+  std::array<std::vector<float>, 3> buffers;
+  size_t nextBuffer = 0;
+};
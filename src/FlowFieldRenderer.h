@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cmath>
+
+#include "Renderer.h"
+
+// Renders a 2-channel flow field for SmearShader's field1Texture/field2Texture straight into
+// an RG16F fbo: the same fractal gradient noise as FlowFieldNoise (identical for seed 0, up to
+// float precision), plain or curl, but with no CPU work or upload. update() only redraws when a
+// parameter, the size or the quantised time has changed.
+class FlowFieldRenderer : public Renderer {
+
+public:
+  // Redraws if needed for timeSeconds (scaled by "Time Scale" into the noise's third axis and
+  // quantised to "Time Quantum"). Returns true if the field was redrawn.
+  bool update(float timeSeconds) {
+    const float quantum = timeQuantumParameter;
+    const float time = (quantum > 0.0f ? std::floor(timeSeconds / quantum) * quantum : timeSeconds) * timeScaleParameter;
+    const State state { fbo.getWidth(), fbo.getHeight(), time, scaleParameter, octavesParameter, seedParameter,
+                        curlParameter, curlAmountParameter };
+    if (drawn && state == lastState) return false;
+    renderState(state);
+    lastState = state;
+    drawn = true;
+    return true;
+  }
+
+  // Forces a redraw on the next update().
+  void invalidate() { drawn = false; }
+
+  ofTexture& getTexture() { return fbo.getTexture(); }
+
+  std::string getParameterGroupName() { return "Flow Field"; }
+
+  ofParameterGroup& getParameterGroup() {
+    if (parameters.size() == 0) {
+      parameters.setName(getParameterGroupName());
+      parameters.add(scaleParameter);
+      parameters.add(octavesParameter);
+      parameters.add(seedParameter);
+      parameters.add(timeScaleParameter);
+      parameters.add(timeQuantumParameter);
+      parameters.add(curlParameter);
+      parameters.add(curlAmountParameter);
+    }
+    return parameters;
+  }
+
+  ofParameter<float> scaleParameter { "Scale", 0.005, 0.0001, 0.05 }; // noise units per pixel
+  ofParameter<int> octavesParameter { "Octaves", 2, 1, 6 };
+  ofParameter<int> seedParameter { "Seed", 0, 0, 1000 };
+  ofParameter<float> timeScaleParameter { "Time Scale", 0.1, 0.0, 2.0 };
+  ofParameter<float> timeQuantumParameter { "Time Quantum", 1.0 / 30.0, 0.0, 1.0 }; // seconds; 0 redraws on any time change
+  ofParameter<bool> curlParameter { "Curl", false }; // divergence-free
+  ofParameter<float> curlAmountParameter { "Curl Amount", 0.5, 0.0, 4.0 };
+
+protected:
+  GLint getInternalFormat() override { return GL_RG16F; }
+
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform float scale;
+                uniform float time;
+                uniform int octaves;
+                uniform uint seedHash;
+                uniform int curl;
+                uniform float curlAmount;
+                uniform vec2 secondChannelOffset;
+                out vec4 fragColor;
+
+                uint hash(ivec3 c) {
+                  uint h = uint(c.x) * 0x8da6b343u ^ uint(c.y) * 0xd8163841u ^ uint(c.z) * 0xcb1ab31fu ^ seedHash;
+                  h ^= h >> 13;
+                  h *= 0x5bd1e995u;
+                  h ^= h >> 15;
+                  return h;
+                }
+
+                // The 12 cube-edge gradients of improved Perlin noise (4 repeated).
+                vec3 gradient(uint h) {
+                  uint g = h & 15u;
+                  float su = (g & 1u) != 0u ? -1.0 : 1.0;
+                  float sv = (g & 2u) != 0u ? -1.0 : 1.0;
+                  bool uIsX = g < 8u;
+                  bool vIsY = g < 4u;
+                  bool vIsX = g == 12u || g == 14u;
+                  return vec3((uIsX ? su : 0.0) + (vIsX ? sv : 0.0),
+                              (uIsX ? 0.0 : su) + (vIsY ? sv : 0.0),
+                              (vIsY || vIsX) ? 0.0 : sv);
+                }
+
+                // (value, d/dx, d/dy)
+                vec3 noise(vec3 p) {
+                  vec3 fl = floor(p);
+                  ivec3 i0 = ivec3(fl);
+                  vec3 f = p - fl;
+                  vec3 w = f * f * f * (f * (f * 6.0 - 15.0) + 10.0);
+                  vec2 dw = 30.0 * f.xy * f.xy * (f.xy * (f.xy - 2.0) + 1.0);
+
+                  vec3 result = vec3(0.0);
+                  for (int k = 0; k < 2; ++k) {
+                    for (int j = 0; j < 2; ++j) {
+                      for (int i = 0; i < 2; ++i) {
+                        vec3 corner = vec3(i, j, k);
+                        vec3 g = gradient(hash(i0 + ivec3(i, j, k)));
+                        float d = dot(g, f - corner);
+                        vec3 wt = mix(1.0 - w, w, corner);
+                        vec2 dwt = mix(-dw, dw, corner.xy);
+                        result.x += wt.x * wt.y * wt.z * d;
+                        result.y += wt.z * wt.y * (dwt.x * d + wt.x * g.x);
+                        result.z += wt.z * wt.x * (dwt.y * d + wt.y * g.y);
+                      }
+                    }
+                  }
+                  return result;
+                }
+
+                vec3 fractalNoise(vec3 p) {
+                  vec3 sum = vec3(0.0);
+                  float amplitude = 1.0;
+                  float frequency = 1.0;
+                  float norm = 0.0;
+                  for (int octave = 0; octave < octaves; ++octave) {
+                    vec3 n = noise(p * frequency);
+                    sum += amplitude * vec3(n.x, n.yz * frequency);
+                    norm += amplitude;
+                    amplitude *= 0.5;
+                    frequency *= 2.0;
+                  }
+                  return sum / max(norm, 1e-6);
+                }
+
+                void main() {
+                  vec3 p = vec3((gl_FragCoord.xy - 0.5) * scale, time);
+                  vec3 n = fractalNoise(p);
+                  if (curl == 1) {
+                    fragColor = vec4(0.5 + curlAmount * n.z, 0.5 - curlAmount * n.y, 0.0, 1.0);
+                  } else {
+                    vec3 n2 = fractalNoise(p + vec3(secondChannelOffset, 0.0));
+                    fragColor = vec4(0.5 + 0.5 * n.x, 0.5 + 0.5 * n2.x, 0.0, 1.0);
+                  }
+                }
+                );
+  }
+
+private:
+  struct State {
+    float width;
+    float height;
+    float time;
+    float scale;
+    int octaves;
+    int seed;
+    bool curl;
+    float curlAmount;
+    bool operator==(const State&) const = default;
+  };
+
+  void renderState(const State& state) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
+    fbo.begin();
+    shader.begin();
+    {
+      shader.setUniform1f("scale", state.scale);
+      shader.setUniform1f("time", state.time);
+      shader.setUniform1i("octaves", state.octaves);
+      glUniform1ui(shader.getUniformLocation("seedHash"), static_cast<GLuint>(state.seed) * 0x9e3779b9u);
+      shader.setUniform1i("curl", state.curl ? 1 : 0);
+      shader.setUniform1f("curlAmount", state.curlAmount);
+      shader.setUniform2f("secondChannelOffset", glm::vec2 { 97.3f, 131.9f }); // as FlowFieldNoise
+      ofDrawRectangle(0, 0, fbo.getWidth(), fbo.getHeight());
+    }
+    shader.end();
+    fbo.end();
+    ofPopStyle();
+  }
+
+  ofParameterGroup parameters;
+  State lastState {};
+  bool drawn = false;
+};
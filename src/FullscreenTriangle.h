@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ofGLUtils.h"
+#include "GlCounters.h"
+
+// One triangle that covers the whole viewport (clip-space corners (-1,-1), (3,-1), (-1,3)),
+// with texcoords that run 0..1 across the viewport, for fullscreen passes drawn with an identity
+// modelViewProjectionMatrix. Uses OF's default attribute locations (position = 0, texcoord = 3).
+// GL objects are created lazily on the first draw.
+class FullscreenTriangle {
+public:
+  FullscreenTriangle() {}
+
+  ~FullscreenTriangle() {
+    if (vao == 0) return;
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+  }
+
+  FullscreenTriangle(const FullscreenTriangle&) = delete;
+  FullscreenTriangle& operator=(const FullscreenTriangle&) = delete;
+
+  // Draws with the currently bound shader.
+  void draw() {
+    if (vao == 0) setup();
+    glBindVertexArray(vao);
+    OFXRENDERER_GL_COUNT_CURRENT(drawCalls, 1);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+  }
+
+private:
+  static constexpr GLuint POSITION_LOCATION = 0;
+  static constexpr GLuint TEXCOORD_LOCATION = 3;
+
+  void setup() {
+    // x, y, u, v
+    static const float vertices[] = {
+      -1.0f, -1.0f, 0.0f, 0.0f,
+       3.0f, -1.0f, 2.0f, 0.0f,
+      -1.0f,  3.0f, 0.0f, 2.0f,
+    };
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(POSITION_LOCATION);
+    glVertexAttribPointer(POSITION_LOCATION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(TEXCOORD_LOCATION);
+    glVertexAttribPointer(TEXCOORD_LOCATION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                          reinterpret_cast<const void*>(2 * sizeof(float)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+  }
+
+  GLuint vao = 0;
+  GLuint vbo = 0;
+};
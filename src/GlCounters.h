@@ -0,0 +1,308 @@
+#pragma once
+
+// Per-frame counts of the GL work ofxRenderer issues, broken down by Shader subclass, for
+// finding redundant state changes and driver overhead. Only compiled in when
+// OFXRENDERER_GL_COUNTERS is defined; otherwise the OFXRENDERER_GL_COUNT* macros expand to
+// nothing and Shader keeps a plain ofShader.
+//
+// Program binds, uniform updates and setUniformTexture binds are counted by CountedShader,
+// which Shader uses in place of ofShader. Draws, FBO binds and clears are counted where this
+// addon issues them (drawPass, the fullscreen triangle, tile and instanced draws, Renderer,
+// PingPongFbo, the fluid passes...), not by intercepting GL, so GL work done elsewhere (OF's
+// own drawing, other addons) is not included. Draws issued by shared geometry are attributed to
+// the Shader whose program is bound.
+//
+// Where GL_ARB_pipeline_statistics_query is available, each program bind also counts fragment
+// shader invocations with a query read back without waiting, so a frame's counts are published
+// once its queries have landed, usually 2-3 frames later. Otherwise they are published at the
+// start of the next frame.
+
+#ifdef OFXRENDERER_GL_COUNTERS
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ofMain.h"
+#include "TypeName.h"
+
+struct GlCounts {
+  uint32_t drawCalls = 0;
+  uint32_t fboBinds = 0;       // including the rebind when an fbo ends
+  uint32_t programBinds = 0;
+  uint32_t textureBinds = 0;
+  uint32_t uniformUpdates = 0; // including setUniformTexture
+  uint32_t clears = 0;
+  uint64_t fragmentInvocations = 0; // 0 without GL_ARB_pipeline_statistics_query
+
+  GlCounts& operator+=(const GlCounts& other) {
+    drawCalls += other.drawCalls;
+    fboBinds += other.fboBinds;
+    programBinds += other.programBinds;
+    textureBinds += other.textureBinds;
+    uniformUpdates += other.uniformUpdates;
+    clears += other.clears;
+    fragmentInvocations += other.fragmentInvocations;
+    return *this;
+  }
+
+  std::string toString() const {
+    std::ostringstream text;
+    text << "draws " << drawCalls << ", fbo binds " << fboBinds << ", programs " << programBinds
+         << ", textures " << textureBinds << ", uniforms " << uniformUpdates << ", clears " << clears;
+    if (fragmentInvocations) text << ", fragments " << fragmentInvocations;
+    return text.str();
+  }
+};
+
+class GlCounters {
+
+public:
+  static GlCounters& get() {
+    // Deliberately never destroyed, like the shared FullscreenTriangle: it holds GL queries.
+    static auto* counters = new GlCounters();
+    return *counters;
+  }
+
+  // Counts of the newest published frame, by demangled Shader subclass name ("(none)" for work
+  // issued with no Shader program bound).
+  const std::map<std::string, GlCounts>& getFrameCounts() const { return publishedCounts; }
+  const GlCounts& getFrameTotal() const { return publishedTotal; }
+  uint64_t getFrameNumber() const { return publishedFrame; }
+
+  // Logs the published counts every `frames` frames; 0 (the default) disables logging.
+  void setLogInterval(int frames) { logInterval = std::max(0, frames); }
+
+  // Turns the fragment invocation queries off (or back on, where supported).
+  void setStatisticsEnabled(bool enabled) { statisticsEnabled = enabled; }
+
+  // owner is a typeid name, or nullptr for the currently bound Shader's.
+  void add(const char* owner, uint32_t GlCounts::*counter, uint32_t n = 1) {
+    if (!owner) owner = getCurrentOwner();
+    frames.back().counts[owner].*counter += n;
+  }
+
+  void beginProgram(const char* owner) {
+    if (!owner) owner = NO_OWNER;
+    add(owner, &GlCounts::programBinds);
+    programOwners.push_back(owner);
+#ifdef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+    // Statistics queries don't nest, so a program begun inside another is counted with it.
+    if (statisticsQuery || !isStatisticsSupported()) return;
+    statisticsQuery = acquireQuery();
+    statisticsDepth = programOwners.size();
+    glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, statisticsQuery);
+#endif
+  }
+
+  void endProgram() {
+    if (programOwners.empty()) return;
+#ifdef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+    if (statisticsQuery && programOwners.size() == statisticsDepth) {
+      glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+      frames.back().queries.push_back({ programOwners.back(), statisticsQuery });
+      statisticsQuery = 0;
+    }
+#endif
+    programOwners.pop_back();
+  }
+
+private:
+  static constexpr const char* NO_OWNER = "(none)";
+  static constexpr size_t MAX_FRAMES_IN_FLIGHT = 6;
+  static constexpr GLsizei QUERY_BATCH = 32;
+
+  struct StatisticsQuery {
+    const char* owner;
+    GLuint query;
+  };
+
+  struct Frame {
+    uint64_t number = 0;
+    std::unordered_map<const char*, GlCounts> counts;
+    std::vector<StatisticsQuery> queries;
+  };
+
+  GlCounters() {
+    frames.emplace_back();
+    ofAddListener(ofEvents().update, this, &GlCounters::onUpdate, OF_EVENT_ORDER_BEFORE_APP);
+  }
+
+  const char* getCurrentOwner() const { return programOwners.empty() ? NO_OWNER : programOwners.back(); }
+
+  void onUpdate(ofEventArgs&) {
+    const uint64_t number = frames.back().number + 1;
+    frames.emplace_back();
+    frames.back().number = number;
+    collect();
+  }
+
+  // Publishes finished frames, oldest first, stopping at the first with queries in flight.
+  // Never waits: if the GPU is too far behind, a frame is published without its statistics.
+  void collect() {
+    while (frames.size() > 1) {
+      Frame& frame = frames.front();
+      const bool dropStatistics = frames.size() > MAX_FRAMES_IN_FLIGHT;
+      for (const auto& query : frame.queries) {
+        if (!dropStatistics && !isAvailable(query.query)) return;
+      }
+      for (const auto& query : frame.queries) {
+        if (!dropStatistics) {
+          GLuint64 invocations = 0;
+          glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &invocations);
+          frame.counts[query.owner].fragmentInvocations += invocations;
+        }
+        freeQueries.push_back(query.query);
+      }
+      publish(frame);
+      frames.pop_front();
+    }
+  }
+
+  void publish(const Frame& frame) {
+    publishedCounts.clear();
+    publishedTotal = {};
+    for (const auto& [owner, counts] : frame.counts) {
+      publishedCounts[owner == NO_OWNER ? std::string { NO_OWNER } : demangledTypeName(owner)] += counts;
+      publishedTotal += counts;
+    }
+    publishedFrame = frame.number;
+    if (logInterval == 0 || publishedFrame % logInterval != 0) return;
+    ofLogNotice("GlCounters") << "frame " << publishedFrame << ": " << publishedTotal.toString();
+    for (const auto& [name, counts] : publishedCounts) {
+      ofLogNotice("GlCounters") << "  " << name << ": " << counts.toString();
+    }
+  }
+
+#ifdef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+  bool isStatisticsSupported() {
+    if (!statisticsChecked) {
+      statisticsSupported = ofGLCheckExtension("GL_ARB_pipeline_statistics_query");
+      statisticsChecked = true;
+    }
+    return statisticsEnabled && statisticsSupported;
+  }
+#endif
+
+  static bool isAvailable(GLuint query) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available == GL_TRUE;
+  }
+
+  GLuint acquireQuery() {
+    if (freeQueries.empty()) {
+      freeQueries.resize(QUERY_BATCH);
+      glGenQueries(QUERY_BATCH, freeQueries.data());
+    }
+    const GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+  }
+
+  std::deque<Frame> frames; // back is being recorded
+  std::vector<const char*> programOwners; // bound Shader programs, innermost last
+  bool statisticsEnabled = true;
+#ifdef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+  GLuint statisticsQuery = 0; // active fragment invocation query
+  size_t statisticsDepth = 0;
+  bool statisticsChecked = false;
+  bool statisticsSupported = false;
+#endif
+  std::vector<GLuint> freeQueries;
+  int logInterval = 0;
+  std::map<std::string, GlCounts> publishedCounts;
+  GlCounts publishedTotal;
+  uint64_t publishedFrame = 0;
+};
+
+// An ofShader that counts its program binds and uniform updates for its owning Shader.
+class CountedShader : public ofShader {
+
+public:
+  void setOwner(const char* owner_) { owner = owner_; }
+
+  void begin() const {
+    GlCounters::get().beginProgram(owner);
+    ofShader::begin();
+  }
+
+  void end() const {
+    ofShader::end();
+    GlCounters::get().endProgram();
+  }
+
+  template<typename... Args>
+  void setUniformTexture(Args&&... args) const {
+    GlCounters::get().add(owner, &GlCounts::uniformUpdates);
+    GlCounters::get().add(owner, &GlCounts::textureBinds);
+    ofShader::setUniformTexture(std::forward<Args>(args)...);
+  }
+
+// Forwards every overload of an ofShader setter. The vector overloads are spelled out as well
+// so braced arguments like { 0.0f, 0.0f } still convert.
+#define OFXRENDERER_COUNTED_UNIFORM(setter) \
+  template<typename... Args> \
+  void setter(Args&&... args) const { \
+    GlCounters::get().add(owner, &GlCounts::uniformUpdates); \
+    ofShader::setter(std::forward<Args>(args)...); \
+  }
+  OFXRENDERER_COUNTED_UNIFORM(setUniform1i)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform2i)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform3i)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform4i)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform1f)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform2f)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform3f)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform4f)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform1fv)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform2fv)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform3fv)
+  OFXRENDERER_COUNTED_UNIFORM(setUniform4fv)
+  OFXRENDERER_COUNTED_UNIFORM(setUniformMatrix4f)
+#undef OFXRENDERER_COUNTED_UNIFORM
+
+  void setUniform2f(const std::string& name, const glm::vec2& v) const {
+    GlCounters::get().add(owner, &GlCounts::uniformUpdates);
+    ofShader::setUniform2f(name, v);
+  }
+
+  void setUniform3f(const std::string& name, const glm::vec3& v) const {
+    GlCounters::get().add(owner, &GlCounts::uniformUpdates);
+    ofShader::setUniform3f(name, v);
+  }
+
+  void setUniform4f(const std::string& name, const glm::vec4& v) const {
+    GlCounters::get().add(owner, &GlCounts::uniformUpdates);
+    ofShader::setUniform4f(name, v);
+  }
+
+private:
+  const char* owner = nullptr; // typeid name
+};
+
+// In a member function: counts for the dynamic type of *this.
+#define OFXRENDERER_GL_COUNT(counter, n) GlCounters::get().add(typeid(*this).name(), &GlCounts::counter, n)
+// Counts for type, e.g. outside any member function.
+#define OFXRENDERER_GL_COUNT_FOR(type, counter, n) GlCounters::get().add(typeid(type).name(), &GlCounts::counter, n)
+// Counts for the Shader whose program is bound, e.g. in shared geometry.
+#define OFXRENDERER_GL_COUNT_CURRENT(counter, n) GlCounters::get().add(nullptr, &GlCounts::counter, n)
+// In a member function: one draw of a texture (or fbo), which also binds it.
+#define OFXRENDERER_GL_COUNT_TEXTURE_DRAW() \
+  do { OFXRENDERER_GL_COUNT(drawCalls, 1); OFXRENDERER_GL_COUNT(textureBinds, 1); } while (0)
+
+#else
+
+#define OFXRENDERER_GL_COUNT(counter, n) ((void)0)
+#define OFXRENDERER_GL_COUNT_FOR(type, counter, n) ((void)0)
+#define OFXRENDERER_GL_COUNT_CURRENT(counter, n) ((void)0)
+#define OFXRENDERER_GL_COUNT_TEXTURE_DRAW() ((void)0)
+
+#endif
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ofGLUtils.h"
+#include "TraceRecorder.h"
+
+// GPU timing for labelled, nestable scopes that never waits on the GPU. Each scope records a
+// GL_TIMESTAMP query at begin and end (timestamps nest, unlike GL_TIME_ELAPSED queries); the
+// queries of a frame are read back once the GPU has got past them, normally 2-3 frames later,
+// and folded into rolling per-label statistics. Query objects are pooled and reused.
+//
+//   timers.beginFrame();                    // once per frame, before any scope
+//   { GpuTimerPool::Scope s(timers, "fluid"); { GpuTimerPool::Scope t(timers, "advect"); ... } }
+//   timers.getStats("fluid/advect").p95Ms
+//
+// Nested scopes are labelled by their path ("parent/child"). Scopes with the same label in one
+// frame are summed into that frame's sample. Scopes are also trace events (see TraceRecorder),
+// whether or not the pool is enabled.
+class GpuTimerPool {
+
+public:
+  struct Stats {
+    float lastMs = 0.0f;
+    float minMs = 0.0f;
+    float meanMs = 0.0f;
+    float p95Ms = 0.0f;
+    size_t sampleCount = 0; // in the rolling window
+  };
+
+  class Scope {
+  public:
+    Scope(GpuTimerPool& pool_, const std::string& label) : pool(pool_) { pool.begin(label); }
+    ~Scope() { pool.end(); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  private:
+    GpuTimerPool& pool;
+  };
+
+  // windowSize: samples per label kept for the rolling statistics.
+  explicit GpuTimerPool(size_t windowSize_ = 120) : windowSize(std::max<size_t>(1, windowSize_)) {}
+
+  ~GpuTimerPool() {
+    for (auto& frame : frames) releaseQueries(frame);
+    if (!freeQueries.empty()) glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+  }
+
+  GpuTimerPool(const GpuTimerPool&) = delete;
+  GpuTimerPool& operator=(const GpuTimerPool&) = delete;
+
+  void setEnabled(bool enabled_) { enabled = enabled_; }
+  bool isEnabled() const { return enabled; }
+
+  // Collects every finished frame and starts recording a new one.
+  void beginFrame() {
+    stack.clear();
+    collect();
+    if (!enabled) return;
+    frames.emplace_back();
+    // Never wait: if the GPU is this far behind, drop the oldest frame's results.
+    while (frames.size() > MAX_FRAMES_IN_FLIGHT) {
+      releaseQueries(frames.front());
+      frames.pop_front();
+    }
+  }
+
+  void begin(const std::string& label) {
+    OFXRENDERER_TRACE_BEGIN(label);
+    if (!enabled || frames.empty()) return;
+    const std::string path = stack.empty() ? label : labels[frames.back().scopes[stack.back()].label] + "/" + label;
+    Frame& frame = frames.back();
+    frame.scopes.push_back({ getLabelIndex(path), acquireQuery(), 0 });
+    glQueryCounter(frame.scopes.back().begin, GL_TIMESTAMP);
+    frame.lastQuery = frame.scopes.back().begin;
+    stack.push_back(frame.scopes.size() - 1);
+  }
+
+  void end() {
+    OFXRENDERER_TRACE_END();
+    if (!enabled || frames.empty() || stack.empty()) return;
+    Frame& frame = frames.back();
+    ScopeQueries& scope = frame.scopes[stack.back()];
+    stack.pop_back();
+    scope.end = acquireQuery();
+    glQueryCounter(scope.end, GL_TIMESTAMP);
+    frame.lastQuery = scope.end;
+  }
+
+  // Statistics for a label path; all zero if it has no samples yet.
+  Stats getStats(const std::string& label) const {
+    const auto it = labelIndices.find(label);
+    return it == labelIndices.end() ? Stats {} : computeStats(windows[it->second]);
+  }
+
+  // Calls fn(label, stats) for every label seen so far, in first-seen order.
+  template<typename F>
+  void forEachStats(F&& fn) const {
+    for (size_t i = 0; i < labels.size(); ++i) fn(labels[i], computeStats(windows[i]));
+  }
+
+private:
+  static constexpr size_t MAX_FRAMES_IN_FLIGHT = 6;
+  static constexpr GLsizei QUERY_BATCH = 32;
+
+  struct ScopeQueries {
+    size_t label;
+    GLuint begin;
+    GLuint end; // 0 while the scope is open
+  };
+
+  struct Frame {
+    std::vector<ScopeQueries> scopes;
+    GLuint lastQuery = 0; // issued last
+  };
+
+  struct Window {
+    std::vector<float> samples; // ring of windowSize
+    size_t next = 0;
+    float last = 0.0f;
+  };
+
+  size_t getLabelIndex(const std::string& path) {
+    const auto [it, inserted] = labelIndices.try_emplace(path, labels.size());
+    if (inserted) {
+      labels.push_back(path);
+      windows.emplace_back();
+    }
+    return it->second;
+  }
+
+  GLuint acquireQuery() {
+    if (freeQueries.empty()) {
+      freeQueries.resize(QUERY_BATCH);
+      glGenQueries(QUERY_BATCH, freeQueries.data());
+    }
+    const GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+  }
+
+  void releaseQueries(const Frame& frame) {
+    for (const auto& scope : frame.scopes) {
+      freeQueries.push_back(scope.begin);
+      if (scope.end) freeQueries.push_back(scope.end);
+    }
+  }
+
+  // Reads back finished frames, oldest first, stopping at the first one the GPU hasn't reached.
+  void collect() {
+    while (!frames.empty()) {
+      Frame& frame = frames.front();
+      if (frame.lastQuery) {
+        // Timestamps complete in order, so the frame is done when its last query is.
+        if (!isAvailable(frame.lastQuery)) return;
+        frameTotals.assign(labels.size(), -1.0f);
+        for (const auto& scope : frame.scopes) {
+          if (!scope.end) continue;
+          GLuint64 beginNs = 0, endNs = 0;
+          glGetQueryObjectui64v(scope.begin, GL_QUERY_RESULT, &beginNs);
+          glGetQueryObjectui64v(scope.end, GL_QUERY_RESULT, &endNs);
+          float& total = frameTotals[scope.label];
+          total = std::max(total, 0.0f) + static_cast<float>(endNs - beginNs) / 1.0e6f;
+        }
+        for (size_t label = 0; label < frameTotals.size(); ++label) {
+          if (frameTotals[label] >= 0.0f) addSample(label, frameTotals[label]);
+        }
+      }
+      releaseQueries(frame);
+      frames.pop_front();
+    }
+  }
+
+  static bool isAvailable(GLuint query) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available == GL_TRUE;
+  }
+
+  void addSample(size_t label, float ms) {
+    Window& window = windows[label];
+    if (window.samples.size() < windowSize) {
+      window.samples.push_back(ms);
+    } else {
+      window.samples[window.next] = ms;
+    }
+    window.next = (window.next + 1) % windowSize;
+    window.last = ms;
+  }
+
+  Stats computeStats(const Window& window) const {
+    Stats stats;
+    if (window.samples.empty()) return stats;
+    scratch = window.samples;
+    stats.lastMs = window.last;
+    stats.sampleCount = scratch.size();
+    float sum = 0.0f;
+    for (float sample : scratch) sum += sample;
+    stats.meanMs = sum / static_cast<float>(scratch.size());
+    stats.minMs = *std::min_element(scratch.begin(), scratch.end());
+    const size_t p95 = std::min(scratch.size() - 1, (scratch.size() * 95) / 100);
+    std::nth_element(scratch.begin(), scratch.begin() + p95, scratch.end());
+    stats.p95Ms = scratch[p95];
+    return stats;
+  }
+
+  const size_t windowSize;
+  bool enabled = true;
+  std::deque<Frame> frames;
+  std::vector<size_t> stack; // open scopes of the current frame
+  std::vector<GLuint> freeQueries;
+  std::unordered_map<std::string, size_t> labelIndices;
+  std::vector<std::string> labels;
+  std::vector<Window> windows;
+  std::vector<float> frameTotals; // per label while collecting a frame, -1 if absent
+  mutable std::vector<float> scratch;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// IEEE 754 binary16 <-> float conversion for CPU-side handling of GL_HALF_FLOAT data.
+// The span conversions use F16C (x86, built with -mf16c or -march supporting it) or NEON
+// (arm64) for whole vectors and the scalar functions for the rest.
+namespace HalfFloat {
+
+inline float toFloat(uint16_t half) {
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1fu;
+  uint32_t mantissa = half & 0x3ffu;
+  uint32_t bits;
+  if (exponent == 0x1fu) {
+    bits = sign | 0x7f800000u | (mantissa << 13); // inf / nan
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign; // +-0
+  } else {
+    // Subnormal half: normalise into a float.
+    uint32_t e = 113;
+    while (!(mantissa & 0x400u)) {
+      mantissa <<= 1;
+      --e;
+    }
+    bits = sign | (e << 23) | ((mantissa & 0x3ffu) << 13);
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Rounds to nearest even; out of range values become infinities, NaNs stay NaNs.
+inline uint16_t fromFloat(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+  const uint32_t magnitude = bits & 0x7fffffffu;
+  if (magnitude > 0x7f800000u) return sign | 0x7e00u; // nan
+  if (magnitude >= 0x47800000u) return sign | 0x7c00u; // >= 65536 (or inf)
+  if (magnitude < 0x38800000u) {
+    // Subnormal half (or zero).
+    if (magnitude < 0x33000000u) return sign;
+    const uint32_t shift = 126 - (magnitude >> 23);
+    const uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+    uint32_t half = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1u))) ++half;
+    return sign | static_cast<uint16_t>(half);
+  }
+  // Rebias the exponent; a carry out of the mantissa correctly rounds up to the next exponent
+  // (or to infinity).
+  uint32_t half = (magnitude - 0x38000000u) >> 13;
+  const uint32_t remainder = magnitude & 0x1fffu;
+  if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) ++half;
+  return sign | static_cast<uint16_t>(half);
+}
+
+// Converts min(halves.size(), floats.size()) values.
+inline void toFloats(std::span<const uint16_t> halves, std::span<float> floats) {
+  const size_t count = std::min(halves.size(), floats.size());
+  size_t i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= count; i += 8) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(halves.data() + i));
+    _mm256_storeu_ps(floats.data() + i, _mm256_cvtph_ps(h));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 4 <= count; i += 4) {
+    const float16x4_t h = vreinterpret_f16_u16(vld1_u16(halves.data() + i));
+    vst1q_f32(floats.data() + i, vcvt_f32_f16(h));
+  }
+#endif
+  for (; i < count; ++i) floats[i] = toFloat(halves[i]);
+}
+
+// Converts min(floats.size(), halves.size()) values. `halves` may be write-combined memory
+// (e.g. a mapped pixel unpack buffer): it is only written, front to back.
+inline void fromFloats(std::span<const float> floats, std::span<uint16_t> halves) {
+  const size_t count = std::min(floats.size(), halves.size());
+  size_t i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= count; i += 8) {
+    const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(floats.data() + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(halves.data() + i), h);
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 4 <= count; i += 4) {
+    const float16x4_t h = vcvt_f16_f32(vld1q_f32(floats.data() + i));
+    vst1_u16(halves.data() + i, vreinterpret_u16_f16(h));
+  }
+#endif
+  for (; i < count; ++i) halves[i] = fromFloat(floats[i]);
+}
+
+} // namespace HalfFloat
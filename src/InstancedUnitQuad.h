@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "ofGLUtils.h"
+#include "GlCounters.h"
+
+// A static unit quad (corners at +/-0.5, texcoords 0..1, drawn as a triangle strip) plus a
+// streamed per-instance vertex buffer, so many transformed quads go out in one instanced draw
+// instead of one ofMesh::draw each.
+//
+// The quad uses OF's default attribute locations (position = 0, texcoord = 3). Instance
+// attributes are floats at the caller's locations (use >= 4) and must match the
+// `layout(location = N)` declarations in the vertex shader.
+// GL objects are created lazily on the first draw, so this can live in a Shader that is
+// constructed before there is a GL context.
+class InstancedUnitQuad {
+public:
+  struct InstanceAttribute {
+    GLuint location;
+    GLint components;
+    size_t offset; // bytes into the instance struct
+  };
+
+  InstancedUnitQuad(std::vector<InstanceAttribute> instanceAttributes_, size_t instanceStride_) :
+  instanceAttributes { std::move(instanceAttributes_) },
+  instanceStride { instanceStride_ }
+  {}
+
+  ~InstancedUnitQuad() {
+    if (vao == 0) return;
+    glDeleteBuffers(1, &instanceVbo);
+    glDeleteBuffers(1, &quadVbo);
+    glDeleteVertexArrays(1, &vao);
+  }
+
+  InstancedUnitQuad(const InstancedUnitQuad&) = delete;
+  InstancedUnitQuad& operator=(const InstancedUnitQuad&) = delete;
+
+  // Draws instanceCount quads with the currently bound shader.
+  // instanceData points at instanceCount structs of instanceStride bytes.
+  void draw(const void* instanceData, size_t instanceCount) {
+    if (instanceCount == 0) return;
+    if (vao == 0) setup();
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    const size_t bytes = instanceCount * instanceStride;
+    if (instanceCount > instanceCapacity) {
+      instanceCapacity = std::max(instanceCount, instanceCapacity * 2);
+    }
+    // Orphan the previous contents so the driver doesn't wait on draws still reading them.
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * instanceStride, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instanceData);
+
+    OFXRENDERER_GL_COUNT_CURRENT(drawCalls, 1);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instanceCount));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+  }
+
+private:
+  static constexpr GLuint POSITION_LOCATION = 0;
+  static constexpr GLuint TEXCOORD_LOCATION = 3;
+
+  void setup() {
+    // x, y, u, v
+    static const float quad[] = {
+      -0.5f, -0.5f, 0.0f, 0.0f,
+       0.5f, -0.5f, 1.0f, 0.0f,
+      -0.5f,  0.5f, 0.0f, 1.0f,
+       0.5f,  0.5f, 1.0f, 1.0f,
+    };
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &quadVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(POSITION_LOCATION);
+    glVertexAttribPointer(POSITION_LOCATION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(TEXCOORD_LOCATION);
+    glVertexAttribPointer(TEXCOORD_LOCATION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                          reinterpret_cast<const void*>(2 * sizeof(float)));
+
+    glGenBuffers(1, &instanceVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    for (const auto& attribute : instanceAttributes) {
+      glEnableVertexAttribArray(attribute.location);
+      glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE,
+                            static_cast<GLsizei>(instanceStride), reinterpret_cast<const void*>(attribute.offset));
+      glVertexAttribDivisor(attribute.location, 1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+  }
+
+  std::vector<InstanceAttribute> instanceAttributes;
+  size_t instanceStride;
+  size_t instanceCapacity = 0;
+  GLuint vao = 0;
+  GLuint quadVbo = 0;
+  GLuint instanceVbo = 0;
+};
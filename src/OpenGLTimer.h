@@ -2,6 +2,8 @@
 
 #include "ofGLUtils.h"
 
+// Logs the GPU time of a scope. Waits for the result at the end of the scope, which stalls the
+// pipeline; see GpuTimerPool for timing that can stay enabled.
 class OpenGLTimer {
 public:
   OpenGLTimer() {
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "ofFbo.h"
+#include "ofGLUtils.h"
+#include "ofLog.h"
+
+// Reads FBO contents back to the CPU without stalling: each read is queued into the next
+// pixel-pack buffer of a small ring, fenced, and collected once the GPU has signalled the fence
+// (typically one or two frames later). When every buffer is still in flight a new read is
+// dropped rather than waited for.
+class PboReadback {
+public:
+  explicit PboReadback(size_t numBuffers = 3) : slots(numBuffers) {}
+
+  ~PboReadback() {
+    for (auto& slot : slots) {
+      if (slot.fence) glDeleteSync(slot.fence);
+      if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+    }
+  }
+
+  PboReadback(const PboReadback&) = delete;
+  PboReadback& operator=(const PboReadback&) = delete;
+
+  // Queues a read of a pixel region of the fbo's first color attachment.
+  // `bytes` must match the region size for the given format/type. `tag` is handed back by fetch(),
+  // e.g. to tell which frame a result belongs to. Returns false if no buffer was free.
+  bool read(const ofFbo& fbo, int x, int y, int w, int h, GLenum format, GLenum type, size_t bytes, uint64_t tag = 0) {
+    Slot* slot = findFreeSlot();
+    if (!slot) return false;
+
+    if (slot->pbo == 0) glGenBuffers(1, &slot->pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    if (slot->capacity < bytes) {
+      glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+      slot->capacity = bytes;
+    }
+
+    GLint previousReadFbo = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.getId());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, w, h, format, type, nullptr);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->bytes = bytes;
+    slot->tag = tag;
+    slot->sequence = nextSequence++;
+    return true;
+  }
+
+  // Copies the newest completed read into `data` and returns true. Older completed reads are
+  // released without copying; reads still in flight are left alone. Returns false, leaving
+  // `data` and `tag` alone, if nothing has completed or the buffer can't be mapped.
+  bool fetch(std::vector<uint8_t>& data, uint64_t* tag = nullptr) {
+    Slot* newest = nullptr;
+    for (auto& slot : slots) {
+      if (!slot.fence || !isSignalled(slot.fence)) continue;
+      if (newest && newest->sequence > slot.sequence) {
+        release(slot);
+      } else {
+        if (newest) release(*newest);
+        newest = &slot;
+      }
+    }
+    if (!newest) return false;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, newest->pbo);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, newest->bytes, GL_MAP_READ_BIT);
+    if (mapped) {
+      data.resize(newest->bytes);
+      std::memcpy(data.data(), mapped, newest->bytes);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    const uint64_t newestTag = newest->tag;
+    release(*newest);
+
+    if (!mapped) {
+      ofLogError("PboReadback") << "can't map the pixel-pack buffer";
+      return false;
+    }
+    if (tag) *tag = newestTag;
+    return true;
+  }
+
+  // Whether read() would find a free buffer now.
+  bool hasFreeBuffer() const {
+    for (const auto& slot : slots) {
+      if (!slot.fence) return true;
+    }
+    return false;
+  }
+
+  bool isPending() const {
+    for (const auto& slot : slots) {
+      if (slot.fence) return true;
+    }
+    return false;
+  }
+
+private:
+  struct Slot {
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    size_t capacity = 0;
+    size_t bytes = 0;
+    uint64_t tag = 0;
+    uint64_t sequence = 0;
+  };
+
+  static bool isSignalled(GLsync fence) {
+    const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+  }
+
+  static void release(Slot& slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+  }
+
+  Slot* findFreeSlot() {
+    for (auto& slot : slots) {
+      if (!slot.fence) return &slot;
+    }
+    return nullptr;
+  }
+
+  std::vector<Slot> slots;
+  uint64_t nextSequence = 0;
+};
@@ -2,6 +2,7 @@
 
 #include "ofFbo.h"
 #include "ofGraphics.h"
+#include "GlCounters.h"
 #include <algorithm>
 #include <iterator>
 
@@ -51,8 +52,35 @@ public:
   const ofFbo& getTarget() const { return fbos[currentIndex]; }
   void swap() { currentIndex = 1 - currentIndex; }
   
+  // Commits a pass that only rendered `region` of the target by copying that region back into
+  // the source, without a swap. The rest of the target is left stale, which is fine for passes
+  // that always overwrite the whole target. Region is in pixels; inside an ofFbo OF pixel rows
+  // and GL rows coincide, so no flip is needed.
+  void copyTargetRegionToSource(const ofRectangle& region) {
+    const GLint x0 = static_cast<GLint>(region.x);
+    const GLint y0 = static_cast<GLint>(region.y);
+    const GLint x1 = x0 + static_cast<GLint>(region.width);
+    const GLint y1 = y0 + static_cast<GLint>(region.height);
+    if (x1 <= x0 || y1 <= y0) return;
+
+    GLint previousReadFbo = 0;
+    GLint previousDrawFbo = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFbo);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDrawFbo);
+
+    OFXRENDERER_GL_COUNT(fboBinds, 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, getTarget().getId());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, getSource().getId());
+    glBlitFramebuffer(x0, y0, x1, y1, x0, y0, x1, y1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDrawFbo);
+  }
+
   void clearFloat(ofFloatColor color) {
     std::for_each(std::begin(fbos), std::end(fbos), [color](ofFbo& fbo) {
+      OFXRENDERER_GL_COUNT_FOR(PingPongFbo, fboBinds, 2);
+      OFXRENDERER_GL_COUNT_FOR(PingPongFbo, clears, 1);
       fbo.begin();
       ofClearFloat(color);
       fbo.end();
@@ -65,6 +93,8 @@ public:
   
   void clear(float brightness, float a) {
     std::for_each(std::begin(fbos), std::end(fbos), [brightness, a](ofFbo& fbo) {
+      OFXRENDERER_GL_COUNT_FOR(PingPongFbo, fboBinds, 2);
+      OFXRENDERER_GL_COUNT_FOR(PingPongFbo, clears, 1);
       fbo.begin();
       ofClear(brightness, a);
       fbo.end();
@@ -15,6 +15,8 @@ public:
   }
   
   void clear() {
+    OFXRENDERER_GL_COUNT(fboBinds, 4);
+    OFXRENDERER_GL_COUNT(clears, 2);
     pingPongFbo.getSource().begin();
     ofClear(getClearColor());
     pingPongFbo.getSource().end();
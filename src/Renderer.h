@@ -17,17 +17,22 @@ public:
   }
   
   void clear() {
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo.begin();
     {
+      OFXRENDERER_GL_COUNT(clears, 1);
       ofClear(getClearColor());
     }
     fbo.end();
   }
   
   void render(const ofBaseDraws& fbo_) override {
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo.begin();
     shader.begin();
     {
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
       fbo_.draw(0, 0, fbo.getWidth(), fbo.getHeight());
     }
     shader.end();
@@ -4,6 +4,10 @@
 
 #include "ofMain.h"
 #include "PingPongFbo.h"
+#include "FullscreenTriangle.h"
+#include "TileCoverage.h"
+#include "TraceRecorder.h"
+#include "GlCounters.h"
 
 //#define GLSL(shader) "#version 300 es\nprecision mediump float;\n" #shader
 #define GLSL(shader) "#version 410\n" #shader
@@ -12,9 +16,26 @@
 class Shader {
   
 public:
+  // How drawPass() reaches its target.
+  // Fbo: ofFbo::begin/end around a textured quad (OF pushes matrices, viewport and style per pass).
+  // Direct: binds the framebuffer and viewport itself and draws a fullscreen triangle with an
+  // identity matrix. Fragments and texcoords are the same, so outputs are identical.
+  enum class PassMode {
+    Fbo,
+    Direct,
+  };
+
   Shader() {}
   virtual ~Shader() {}
 
+  void setPassMode(PassMode passMode_) { passMode = passMode_; }
+  PassMode getPassMode() const { return passMode; }
+
+  // When set, drawPass() rasterizes only the coverage's active tiles of targets the coverage was
+  // built for (other targets still get a full pass). Pixels outside the tiles are left untouched.
+  // The coverage is not owned and must outlive its use here.
+  void setTileCoverage(TileCoverage* tileCoverage_) { tileCoverage = tileCoverage_; }
+
   void load() {
     bool shaderLoaded = shader.setupShaderFromSource(GL_VERTEX_SHADER, getVertexShader())
       && shader.setupShaderFromSource(GL_FRAGMENT_SHADER, getFragmentShader())
@@ -24,11 +45,16 @@ public:
       ofLogError() << typeid(*this).name() << " not loaded";
       ofExit();
     }
+#ifdef OFXRENDERER_GL_COUNTERS
+    shader.setOwner(typeid(*this).name());
+#endif
   }
 
   // Basic convenience implementation
   virtual void render(const ofBaseDraws& fbo_) {
+    OFXRENDERER_TRACE_SHADER_SCOPE();
     shader.begin();
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     fbo_.draw(0, 0);
     shader.end();
   }
@@ -44,9 +70,12 @@ public:
   // Basic convenience implementation
   // NOTE: this does not belong in this class. It is for postprocessing a buffer.
   virtual void render(PingPongFbo& fbo_) {
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo_.getTarget().begin();
     {
       shader.begin();
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
       fbo_.getSource().draw(0, 0);
       shader.end();
     }
@@ -55,7 +84,75 @@ public:
   }
 
 protected:
+#ifdef OFXRENDERER_GL_COUNTERS
+  CountedShader shader;
+#else
   ofShader shader;
+#endif
+  PassMode passMode = PassMode::Fbo;
+  TileCoverage* tileCoverage = nullptr;
+
+  // Runs the (already begun) shader over every pixel of target (or its active tiles, see
+  // setTileCoverage()), with source bound as tex0 on unit 0.
+  void drawPass(ofFbo& target, const ofTexture& source) {
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+    const bool tiled = tileCoverage && tileCoverage->matches(target.getWidth(), target.getHeight());
+    if (passMode == PassMode::Fbo && !tiled) {
+      OFXRENDERER_GL_COUNT(fboBinds, 2);
+      target.begin();
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
+      source.draw(0, 0, target.getWidth(), target.getHeight());
+      target.end();
+      return;
+    }
+
+    GLint previousFbo = 0;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.getId());
+    glViewport(0, 0, static_cast<GLsizei>(target.getWidth()), static_cast<GLsizei>(target.getHeight()));
+    shader.setUniformTexture("tex0", source, 0);
+    shader.setUniformMatrix4f("modelViewProjectionMatrix", glm::mat4(1.0f));
+    if (tiled) {
+      tileCoverage->draw();
+    } else {
+      getFullscreenTriangle().draw();
+    }
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFbo);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+  }
+
+  // As above for sources only known as ofBaseDraws. Direct mode and tiles need a texture, so
+  // sources that are neither an ofFbo nor a PingPongFbo always take a full Fbo path.
+  void drawPass(ofFbo& target, const ofBaseDraws& source) {
+    if (passMode == PassMode::Direct || tileCoverage) {
+      if (const auto* fbo = dynamic_cast<const ofFbo*>(&source)) {
+        drawPass(target, fbo->getTexture());
+        return;
+      }
+      if (const auto* pingPong = dynamic_cast<const PingPongFbo*>(&source)) {
+        drawPass(target, pingPong->getSource().getTexture());
+        return;
+      }
+    }
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
+    target.begin();
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
+    source.draw(0, 0, target.getWidth(), target.getHeight());
+    target.end();
+  }
+
+  static FullscreenTriangle& getFullscreenTriangle() {
+    // Shared by all shaders and deliberately never destroyed: its GL objects must not be
+    // released after the context has gone away at exit.
+    static auto* triangle = new FullscreenTriangle();
+    return *triangle;
+  }
 
   virtual std::string getVertexShader() {
     return GLSL(
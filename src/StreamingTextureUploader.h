@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ofTexture.h"
+#include "ofGLUtils.h"
+#include "HalfFloat.h"
+
+// Streams CPU-generated float fields (e.g. flow fields for SmearShader) into half-float
+// textures without blocking on the driver copy. Each upload goes into the next free slot of a
+// small ring: the floats are packed to halves straight into that slot's pixel unpack buffer,
+// copied into the slot's texture from the buffer, and fenced. getTexture() returns the newest
+// slot whose copy has completed, so draws never wait for an upload in flight.
+//
+// Where ARB_buffer_storage is available the unpack buffers are persistently mapped once;
+// otherwise (e.g. macOS, GL 4.1) each upload orphans and maps its buffer.
+class StreamingTextureUploader {
+
+public:
+  StreamingTextureUploader() {}
+
+  ~StreamingTextureUploader() { release(); }
+
+  StreamingTextureUploader(const StreamingTextureUploader&) = delete;
+  StreamingTextureUploader& operator=(const StreamingTextureUploader&) = delete;
+
+  // channels: 1..4 floats per texel (2 for RG flow fields), stored as R16F..RGBA16F.
+  void allocate(int width_, int height_, int channels_ = 2, size_t numSlots = 3) {
+    release();
+    width = width_;
+    height = height_;
+    channels = std::clamp(channels_, 1, 4);
+    bytes = static_cast<size_t>(width) * height * channels * sizeof(uint16_t);
+
+#ifdef GL_MAP_PERSISTENT_BIT
+    persistent = ofGLCheckExtension("GL_ARB_buffer_storage");
+#endif
+
+    slots = std::vector<Slot>(std::max<size_t>(2, numSlots));
+    for (auto& slot : slots) {
+      slot.texture.allocate(width, height, getInternalFormat(), false, getFormat(), GL_HALF_FLOAT);
+      glGenBuffers(1, &slot.pbo);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+#ifdef GL_MAP_PERSISTENT_BIT
+      if (persistent) {
+        constexpr GLbitfield FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, FLAGS);
+        slot.mapped = static_cast<uint16_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, FLAGS));
+        continue;
+      }
+#endif
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    current = 0;
+    nextSequence = 0;
+  }
+
+  bool isAllocated() const { return !slots.empty(); }
+  bool isPersistentlyMapped() const { return persistent; }
+
+  // Queues an upload of width * height * channels interleaved floats (GL row order). Returns
+  // false, dropping the data, when every other slot still has an upload in flight.
+  bool upload(std::span<const float> data) {
+    if (slots.empty() || data.size() < static_cast<size_t>(width) * height * channels) return false;
+    collect();
+    Slot* slot = findFreeSlot();
+    if (!slot) return false;
+
+    const size_t count = bytes / sizeof(uint16_t);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+    if (slot->mapped) {
+      // The slot's fence has signalled, so the GPU is done reading this buffer.
+      HalfFloat::fromFloats(data, { slot->mapped, count });
+    } else {
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW); // orphan
+      auto* halves = static_cast<uint16_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+      if (!halves) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+      }
+      HalfFloat::fromFloats(data, { halves, count });
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    const auto& textureData = slot->texture.getTextureData();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(textureData.textureTarget, textureData.textureID);
+    glTexSubImage2D(textureData.textureTarget, 0, 0, 0, width, height, getFormat(), GL_HALF_FLOAT, nullptr);
+    glBindTexture(textureData.textureTarget, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->sequence = ++nextSequence;
+    return true;
+  }
+
+  // The newest texture whose upload has completed (blank until the first one has).
+  ofTexture& getTexture() {
+    collect();
+    return slots[current].texture;
+  }
+
+private:
+  struct Slot {
+    ofTexture texture;
+    GLuint pbo = 0;
+    uint16_t* mapped = nullptr; // persistent mapping, if any
+    GLsync fence = nullptr;     // upload in flight
+    uint64_t sequence = 0;      // 0 until first uploaded
+  };
+
+  GLenum getFormat() const {
+    switch (channels) {
+      case 1: return GL_RED;
+      case 2: return GL_RG;
+      case 3: return GL_RGB;
+      default: return GL_RGBA;
+    }
+  }
+
+  GLint getInternalFormat() const {
+    switch (channels) {
+      case 1: return GL_R16F;
+      case 2: return GL_RG16F;
+      case 3: return GL_RGB16F;
+      default: return GL_RGBA16F;
+    }
+  }
+
+  // Retires signalled uploads and makes the newest completed slot current.
+  void collect() {
+    for (size_t i = 0; i < slots.size(); ++i) {
+      Slot& slot = slots[i];
+      if (!slot.fence) continue;
+      const GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+      if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+      glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+      if (slot.sequence > slots[current].sequence) current = i;
+    }
+  }
+
+  // A slot that is neither in flight nor current (which may still be bound for drawing).
+  Slot* findFreeSlot() {
+    Slot* oldest = nullptr;
+    for (size_t i = 0; i < slots.size(); ++i) {
+      if (i == current || slots[i].fence) continue;
+      if (!oldest || slots[i].sequence < oldest->sequence) oldest = &slots[i];
+    }
+    return oldest;
+  }
+
+  void release() {
+    for (auto& slot : slots) {
+      if (slot.fence) glDeleteSync(slot.fence);
+      if (slot.mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      }
+      if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+    }
+    slots.clear();
+    persistent = false;
+  }
+
+  int width = 0;
+  int height = 0;
+  int channels = 2;
+  size_t bytes = 0;
+  bool persistent = false;
+  std::vector<Slot> slots;
+  size_t current = 0;
+  uint64_t nextSequence = 0;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ofGLUtils.h"
+#include "GlCounters.h"
+
+// The active part of a field divided into square tiles, as quads that Shader::drawPass()
+// rasterizes instead of the whole target. Horizontal runs of active tiles are merged into one
+// quad each. Vertices are in clip space with texcoords 0..1 over the field (like
+// FullscreenTriangle), so they draw with an identity modelViewProjectionMatrix.
+// Tile row 0 is texture row 0. GL objects are created lazily on the first draw.
+class TileCoverage {
+public:
+  TileCoverage() {}
+
+  ~TileCoverage() {
+    if (vao == 0) return;
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+  }
+
+  TileCoverage(const TileCoverage&) = delete;
+  TileCoverage& operator=(const TileCoverage&) = delete;
+
+  static int getTileCount(int fieldSize, int tileSize) { return (fieldSize + tileSize - 1) / tileSize; }
+
+  // Calls fn(firstTileX, endTileX, tileY) for each horizontal run of non-zero entries of a
+  // tilesX * tilesY row-major mask.
+  template<typename F>
+  static void forEachRun(int tilesX, int tilesY, std::span<const uint8_t> mask, F&& fn) {
+    for (int y = 0; y < tilesY; ++y) {
+      const uint8_t* row = mask.data() + static_cast<size_t>(y) * tilesX;
+      int x = 0;
+      while (x < tilesX) {
+        if (!row[x]) { ++x; continue; }
+        const int first = x;
+        while (x < tilesX && row[x]) ++x;
+        fn(first, x, y);
+      }
+    }
+  }
+
+  // Sets out to a tilesX * tilesY row-major mask grown by radius tiles in every direction (a
+  // square window), wrapping around the edges when wrap is set. scratch holds the horizontal pass.
+  static void dilate(int tilesX, int tilesY, std::span<const uint8_t> mask, int radius, bool wrap,
+                     std::vector<uint8_t>& out, std::vector<uint8_t>& scratch) {
+    const size_t count = static_cast<size_t>(tilesX) * tilesY;
+    out.assign(count, 0);
+    scratch.assign(count, 0);
+    const auto dilateLine = [&](const uint8_t* in, uint8_t* result, int length, size_t stride) {
+      const int r = std::min(radius, length);
+      for (int i = 0; i < length; ++i) {
+        uint8_t active = 0;
+        for (int d = -r; d <= r && !active; ++d) {
+          int j = i + d;
+          if (wrap) {
+            j = (j % length + length) % length;
+          } else if (j < 0 || j >= length) {
+            continue;
+          }
+          active = in[j * stride];
+        }
+        result[i * stride] = active;
+      }
+    };
+    for (int y = 0; y < tilesY; ++y) {
+      const size_t row = static_cast<size_t>(y) * tilesX;
+      dilateLine(mask.data() + row, scratch.data() + row, tilesX, 1);
+    }
+    for (int x = 0; x < tilesX; ++x) {
+      dilateLine(scratch.data() + x, out.data() + x, tilesY, static_cast<size_t>(tilesX));
+    }
+  }
+
+  // Rebuilds the quads for a fieldWidth x fieldHeight field from a row-major mask of
+  // getTileCount(fieldWidth, tileSize) x getTileCount(fieldHeight, tileSize) tiles.
+  void update(int fieldWidth_, int fieldHeight_, int tileSize_, std::span<const uint8_t> activeTiles) {
+    fieldWidth = fieldWidth_;
+    fieldHeight = fieldHeight_;
+    tileSize = tileSize_;
+    const int tilesX = getTileCount(fieldWidth, tileSize);
+    const int tilesY = getTileCount(fieldHeight, tileSize);
+
+    vertices.clear();
+    activeTileCount = 0;
+    forEachRun(tilesX, tilesY, activeTiles, [&](int x0, int x1, int y) {
+      activeTileCount += x1 - x0;
+      const float u0 = static_cast<float>(x0 * tileSize) / fieldWidth;
+      const float u1 = static_cast<float>(std::min(x1 * tileSize, fieldWidth)) / fieldWidth;
+      const float v0 = static_cast<float>(y * tileSize) / fieldHeight;
+      const float v1 = static_cast<float>(std::min((y + 1) * tileSize, fieldHeight)) / fieldHeight;
+      addVertex(u0, v0); addVertex(u1, v0); addVertex(u0, v1);
+      addVertex(u1, v0); addVertex(u1, v1); addVertex(u0, v1);
+    });
+    uploaded = false;
+  }
+
+  // True when the coverage was built for a field of the target's size.
+  bool matches(float width, float height) const {
+    return static_cast<int>(width) == fieldWidth && static_cast<int>(height) == fieldHeight;
+  }
+
+  int getActiveTileCount() const { return activeTileCount; }
+  int getTileSize() const { return tileSize; }
+
+  // Draws the active quads with the currently bound shader.
+  void draw() {
+    if (vertices.empty()) return;
+    if (vao == 0) setup();
+    glBindVertexArray(vao);
+    if (!uploaded) {
+      glBindBuffer(GL_ARRAY_BUFFER, vbo);
+      glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      uploaded = true;
+    }
+    OFXRENDERER_GL_COUNT_CURRENT(drawCalls, 1);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size() / 4));
+    glBindVertexArray(0);
+  }
+
+private:
+  static constexpr GLuint POSITION_LOCATION = 0;
+  static constexpr GLuint TEXCOORD_LOCATION = 3;
+
+  void addVertex(float u, float v) {
+    vertices.insert(vertices.end(), { u * 2.0f - 1.0f, v * 2.0f - 1.0f, u, v });
+  }
+
+  void setup() {
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(POSITION_LOCATION);
+    glVertexAttribPointer(POSITION_LOCATION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(TEXCOORD_LOCATION);
+    glVertexAttribPointer(TEXCOORD_LOCATION, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
+                          reinterpret_cast<const void*>(2 * sizeof(float)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+  }
+
+  int fieldWidth = 0;
+  int fieldHeight = 0;
+  int tileSize = 1;
+  int activeTileCount = 0;
+  std::vector<float> vertices; // x, y, u, v
+  bool uploaded = false;
+  GLuint vao = 0;
+  GLuint vbo = 0;
+};
@@ -0,0 +1,259 @@
+#pragma once
+
+// Chrome trace-event export of shader passes, for looking at frame hitches offline in
+// chrome://tracing or Perfetto. Only compiled in when OFXRENDERER_TRACING is defined; otherwise
+// every OFXRENDERER_TRACE_* macro expands to nothing, so release builds pay nothing.
+//
+//   OFXRENDERER_TRACE_START("trace.json", 120);   // record the next 120 frames, then write
+//
+// Each traced pass becomes two complete events: its CPU submit time on the "CPU submit" track
+// and its GPU execution time (from timestamp queries) on the "GPU" track, both on the CPU
+// clock. GPU results are collected a frame or two late while recording, so nothing stalls until
+// the final flush when the window ends.
+
+#ifdef OFXRENDERER_TRACING
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <typeinfo>
+#include <unordered_set>
+#include <vector>
+
+#include "ofMain.h"
+#include "TypeName.h"
+
+class TraceRecorder {
+
+public:
+  class Scope {
+  public:
+    // typeName: name is a typeid name, demangled when the trace is written.
+    explicit Scope(const char* name, bool typeName = false) { get().begin(name, typeName); }
+    explicit Scope(const std::string& name) { get().begin(name); }
+    ~Scope() { get().end(); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  static TraceRecorder& get() {
+    // Deliberately never destroyed, like the shared FullscreenTriangle: it holds GL queries.
+    static auto* recorder = new TraceRecorder();
+    return *recorder;
+  }
+
+  // Records from now until frameCount app updates have passed, then writes the trace to path
+  // (relative to the data folder). Restarts any recording in progress.
+  void start(const std::string& path_, int frameCount_) {
+    if (recording) stop();
+    path = ofToDataPath(path_, true);
+    frameCount = std::max(1, frameCount_);
+    frame = 0;
+    events.clear();
+    frameStartsUs.clear();
+    startTime = std::chrono::steady_clock::now();
+    GLint64 gpuNowNs = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNowNs);
+    gpuCalibrationNs = gpuNowNs;
+    cpuCalibrationUs = nowUs();
+    frameStartsUs.push_back(cpuCalibrationUs);
+    ofAddListener(ofEvents().update, this, &TraceRecorder::onUpdate, OF_EVENT_ORDER_BEFORE_APP);
+    recording = true;
+  }
+
+  // Ends the recording early and writes what was recorded. Waits for the GPU to finish the
+  // outstanding passes.
+  void stop() {
+    if (!recording) return;
+    recording = false;
+    ofRemoveListener(ofEvents().update, this, &TraceRecorder::onUpdate, OF_EVENT_ORDER_BEFORE_APP);
+    stack.clear();
+    collect(true);
+    write();
+  }
+
+  bool isRecording() const { return recording; }
+
+  // name must outlive the recording (a literal or a typeid name).
+  void begin(const char* name, bool typeName = false) {
+    if (!recording) return;
+    Pass pass;
+    pass.event.name = name;
+    pass.event.typeName = typeName;
+    pass.event.frame = frame;
+    pass.event.cpuBeginUs = nowUs();
+    pass.beginQuery = acquireQuery();
+    glQueryCounter(pass.beginQuery, GL_TIMESTAMP);
+    stack.push_back(pendingBase + pending.size());
+    pending.push_back(pass);
+  }
+
+  void begin(const std::string& name) {
+    if (!recording) return;
+    begin(names.insert(name).first->c_str());
+  }
+
+  void end() {
+    // Scopes opened before the recording started have no entry.
+    if (!recording || stack.empty()) return;
+    Pass& pass = pending[stack.back() - pendingBase];
+    stack.pop_back();
+    pass.endQuery = acquireQuery();
+    glQueryCounter(pass.endQuery, GL_TIMESTAMP);
+    pass.event.cpuEndUs = nowUs();
+  }
+
+private:
+  struct Event {
+    const char* name = "";
+    bool typeName = false;
+    int frame = 0;
+    double cpuBeginUs = 0.0;
+    double cpuEndUs = 0.0;
+    double gpuBeginUs = 0.0;
+    double gpuEndUs = 0.0;
+  };
+
+  struct Pass {
+    Event event;
+    GLuint beginQuery = 0;
+    GLuint endQuery = 0; // 0 while open
+  };
+
+  static constexpr GLsizei QUERY_BATCH = 64;
+
+  TraceRecorder() {}
+
+  void onUpdate(ofEventArgs&) {
+    collect(false);
+    if (++frame >= frameCount) {
+      stop();
+      return;
+    }
+    frameStartsUs.push_back(nowUs());
+  }
+
+  double nowUs() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+  }
+
+  double gpuToCpuUs(GLuint64 gpuNs) const {
+    return cpuCalibrationUs + static_cast<double>(static_cast<GLint64>(gpuNs) - gpuCalibrationNs) / 1000.0;
+  }
+
+  GLuint acquireQuery() {
+    if (freeQueries.empty()) {
+      freeQueries.resize(QUERY_BATCH);
+      glGenQueries(QUERY_BATCH, freeQueries.data());
+    }
+    const GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+  }
+
+  // Moves closed passes whose timestamps have landed into events, oldest first. Timestamps
+  // complete in order, so this stops at the first one still in flight unless wait is set.
+  // Passes left open are dropped once the recording has stopped.
+  void collect(bool wait) {
+    while (!pending.empty()) {
+      Pass& pass = pending.front();
+      if (pass.endQuery) {
+        if (!wait) {
+          GLuint available = GL_FALSE;
+          glGetQueryObjectuiv(pass.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+          if (available != GL_TRUE) return;
+        }
+        GLuint64 beginNs = 0, endNs = 0;
+        glGetQueryObjectui64v(pass.beginQuery, GL_QUERY_RESULT, &beginNs);
+        glGetQueryObjectui64v(pass.endQuery, GL_QUERY_RESULT, &endNs);
+        pass.event.gpuBeginUs = gpuToCpuUs(beginNs);
+        pass.event.gpuEndUs = gpuToCpuUs(endNs);
+        events.push_back(pass.event);
+        freeQueries.push_back(pass.endQuery);
+      } else if (recording) {
+        return;
+      }
+      freeQueries.push_back(pass.beginQuery);
+      pending.pop_front();
+      ++pendingBase;
+    }
+  }
+
+  static std::string displayName(const Event& event) {
+    return event.typeName ? demangledTypeName(event.name) : std::string { event.name };
+  }
+
+  static std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+      if (c == '"' || c == '\\') escaped += '\\';
+      escaped += c;
+    }
+    return escaped;
+  }
+
+  void write() {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+      ofLogError("TraceRecorder") << "can't open " << path;
+      return;
+    }
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ofxRenderer\"}},\n");
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU submit\"}},\n");
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+    for (size_t i = 0; i < frameStartsUs.size(); ++i) {
+      std::fprintf(file, ",\n{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"frame\":%zu}}",
+                   frameStartsUs[i], i);
+    }
+    for (const auto& event : events) {
+      const std::string name = escape(displayName(event));
+      std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}",
+                   name.c_str(), event.cpuBeginUs, event.cpuEndUs - event.cpuBeginUs, event.frame);
+      std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}",
+                   name.c_str(), event.gpuBeginUs, event.gpuEndUs - event.gpuBeginUs, event.frame);
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+    ofLogNotice("TraceRecorder") << "wrote " << events.size() << " passes over " << frameStartsUs.size()
+                                 << " frames to " << path;
+    events.clear();
+  }
+
+  bool recording = false;
+  std::string path;
+  int frameCount = 0;
+  int frame = 0;
+  std::chrono::steady_clock::time_point startTime;
+  GLint64 gpuCalibrationNs = 0;
+  double cpuCalibrationUs = 0.0;
+  std::deque<Pass> pending;
+  size_t pendingBase = 0; // absolute index of pending.front()
+  std::vector<size_t> stack; // absolute indices of open passes
+  std::vector<Event> events;
+  std::vector<double> frameStartsUs;
+  std::vector<GLuint> freeQueries;
+  std::unordered_set<std::string> names; // interned std::string names
+};
+
+#define OFXRENDERER_TRACE_CONCAT_(a, b) a##b
+#define OFXRENDERER_TRACE_CONCAT(a, b) OFXRENDERER_TRACE_CONCAT_(a, b)
+#define OFXRENDERER_TRACE_START(path, frameCount) TraceRecorder::get().start(path, frameCount)
+#define OFXRENDERER_TRACE_STOP() TraceRecorder::get().stop()
+#define OFXRENDERER_TRACE_SCOPE(name) TraceRecorder::Scope OFXRENDERER_TRACE_CONCAT(traceScope, __LINE__) { name }
+// Traces the enclosing member function under the dynamic type of *this.
+#define OFXRENDERER_TRACE_SHADER_SCOPE() TraceRecorder::Scope OFXRENDERER_TRACE_CONCAT(traceScope, __LINE__) { typeid(*this).name(), true }
+#define OFXRENDERER_TRACE_BEGIN(name) TraceRecorder::get().begin(name)
+#define OFXRENDERER_TRACE_END() TraceRecorder::get().end()
+
+#else
+
+#define OFXRENDERER_TRACE_START(path, frameCount) ((void)0)
+#define OFXRENDERER_TRACE_STOP() ((void)0)
+#define OFXRENDERER_TRACE_SCOPE(name) ((void)0)
+#define OFXRENDERER_TRACE_SHADER_SCOPE() ((void)0)
+#define OFXRENDERER_TRACE_BEGIN(name) ((void)0)
+#define OFXRENDERER_TRACE_END() ((void)0)
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+// A readable class name from a typeid name, demangled where the ABI allows.
+inline std::string demangledTypeName(const char* typeName) {
+#if __has_include(<cxxabi.h>)
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(typeName, nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    std::string name { demangled };
+    std::free(demangled);
+    return name;
+  }
+#endif
+  return typeName;
+}
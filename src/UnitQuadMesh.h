@@ -8,6 +8,7 @@
 #pragma once
 
 #include "ofMesh.h"
+#include "GlCounters.h"
 
 class UnitQuadMesh {
 public:
@@ -28,6 +29,7 @@ public:
     ofTranslate(centrePosition);
     ofRotateRad(angleRad);
     ofScale(size.x, size.y);
+    OFXRENDERER_GL_COUNT_CURRENT(drawCalls, 1);
     mesh.draw();
     ofPopMatrix();
   }
@@ -37,6 +39,7 @@ public:
     ofPushMatrix();
     ofTranslate(topLeftPosition + size * 0.5f);
     ofScale(size.x, size.y);
+    OFXRENDERER_GL_COUNT_CURRENT(drawCalls, 1);
     mesh.draw();
     ofPopMatrix();
   }
@@ -14,6 +14,9 @@ public:
   {}
 
   void draw(PingPongFbo& fbo) {
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
+    OFXRENDERER_GL_COUNT(clears, 1);
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     fbo.getTarget().begin();
     {
       ofPushStyle();
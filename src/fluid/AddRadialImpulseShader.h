@@ -1,11 +1,28 @@
 #pragma once
 
 #include "Shader.h"
+#include "ObstacleMaskRenderer.h"
 #include "ofGraphics.h"
 
 class AddRadialImpulseShader : public Shader {
 
 public:
+  // When enabled, only the impulse's bounding rectangle is rasterized and then copied back into
+  // the source buffer, instead of redrawing the whole field and swapping.
+  void setFootprintOnly(bool footprintOnly_) { footprintOnly = footprintOnly_; }
+  bool isFootprintOnly() const { return footprintOnly; }
+
+  // Pixel rectangle that contains every texel the impulse can touch, clipped to the field.
+  // The falloff is evaluated in UV units scaled by the smaller dimension, so on non-square
+  // fields the footprint is an ellipse stretched along the longer axis.
+  static ofRectangle getFootprint(glm::vec2 centerPx, float radiusPx, glm::vec2 size) {
+    const float minDim = std::max(1.0f, std::min(size.x, size.y));
+    const glm::vec2 halfExtent = radiusPx * size / minDim + glm::vec2(1.0f);
+    const glm::vec2 lo = glm::clamp(glm::floor(centerPx - halfExtent), glm::vec2(0.0f), size);
+    const glm::vec2 hi = glm::clamp(glm::ceil(centerPx + halfExtent), glm::vec2(0.0f), size);
+    return { lo.x, lo.y, hi.x - lo.x, hi.y - lo.y };
+  }
+
   // Apply a velocity impulse into the velocities ping-pong FBO.
   // centerPx/radiusPx are in pixel units of the velocity field.
   // addVelocityPx is pixels of desired displacement per step (vector/drag impulse).
@@ -26,11 +43,11 @@ public:
            swirlVelocityPx,
            dt,
            velocities.getSource().getTexture(),
-           false,
-           0.5f,
            false);
   }
 
+  // Thresholds obstacles into a mask on every call; see ObstacleMaskRenderer::buildShared().
+  [[deprecated("pass an ObstacleMaskRenderer mask and obstaclesEnabled instead")]]
   void render(PingPongFbo& velocities,
               glm::vec2 centerPx,
               float radiusPx,
@@ -42,6 +59,26 @@ public:
               bool obstaclesEnabled,
               float obstacleThreshold,
               bool obstacleInvert) {
+    render(velocities,
+           centerPx,
+           radiusPx,
+           addVelocityPx,
+           radialVelocityPx,
+           swirlVelocityPx,
+           dt,
+           obstaclesEnabled ? ObstacleMaskRenderer::buildShared(obstacles, velocities.getWidth(), velocities.getHeight(), obstacleThreshold, obstacleInvert) : obstacles,
+           obstaclesEnabled);
+  }
+
+  void render(PingPongFbo& velocities,
+              glm::vec2 centerPx,
+              float radiusPx,
+              glm::vec2 addVelocityPx,
+              float radialVelocityPx,
+              float swirlVelocityPx,
+              float dt,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
     const auto size = glm::vec2(velocities.getWidth(), velocities.getHeight());
     const glm::vec2 centerUv = centerPx / size;
     const float minDim = std::min(size.x, size.y);
@@ -54,16 +91,18 @@ public:
     const float radialStrengthUv = (radialVelocityPx * invMinDim) / dtSafe;
     const float swirlStrengthUv = (swirlVelocityPx * invMinDim) / dtSafe;
 
+    const ofRectangle footprint = getFootprint(centerPx, radiusPx, size);
+    if (footprintOnly && (footprint.width <= 0.0f || footprint.height <= 0.0f)) return;
+
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
 
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     velocities.getTarget().begin();
     shader.begin();
     shader.setUniformTexture("tex0", velocities.getSource().getTexture(), 0);
-    shader.setUniformTexture("obstacles", obstacles, 1);
+    shader.setUniformTexture("obstacles", obstacleMask, 1);
     shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
-    shader.setUniform1f("obstacleThreshold", obstacleThreshold);
-    shader.setUniform1i("obstacleInvert", obstacleInvert ? 1 : 0);
     shader.setUniform2f("center", centerUv);
     shader.setUniform1f("radius", radiusUv);
     shader.setUniform2f("addVelocity", addVelocityUv);
@@ -77,10 +116,21 @@ public:
     const float maxDisp = 1.0f * dx;
     shader.setUniform1f("maxDisp", maxDisp);
 
-    velocities.getSource().draw(0, 0);
+    if (footprintOnly) {
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
+      velocities.getSource().getTexture().drawSubsection(footprint.x, footprint.y, footprint.width, footprint.height,
+                                                         footprint.x, footprint.y);
+    } else {
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
+      velocities.getSource().draw(0, 0);
+    }
     shader.end();
     velocities.getTarget().end();
-    velocities.swap();
+    if (footprintOnly) {
+      velocities.copyTargetRegionToSource(footprint);
+    } else {
+      velocities.swap();
+    }
 
     ofPopStyle();
   }
@@ -99,10 +149,8 @@ protected:
   std::string getFragmentShader() override {
     return GLSL(
                  uniform sampler2D tex0; // previous velocities
-                 uniform sampler2D obstacles;
+                 uniform sampler2D obstacles; // ObstacleMaskRenderer output
                  uniform int obstaclesEnabled;
-                 uniform float obstacleThreshold;
-                 uniform int obstacleInvert;
                  uniform vec2 center;     // UV space
                  uniform float radius;    // UV space
                  uniform vec2 addVelocity;
@@ -113,19 +161,14 @@ protected:
                  in vec2 texCoordVarying;
                  out vec4 fragColor;
 
-                 float obstacleMask(vec2 uv) {
-                   // Sample obstacles at texel centers to avoid linear-filter bleed at boundaries.
-                   vec2 sz = vec2(textureSize(obstacles, 0));
-                   vec2 uvQ = (floor(uv * sz) + 0.5) / sz;
-                   vec4 o = texture(obstacles, uvQ);
-                   float m = max(o.a, dot(o.rgb, vec3(0.333333)));
-                   if (obstacleInvert == 1) m = 1.0 - m;
-                   return m;
+                 // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                 int obstacleBits(vec2 uv) {
+                   if (obstaclesEnabled == 0) return 0;
+                   return int(texture(obstacles, uv).r * 255.0 + 0.5);
                  }
 
                  float obstacleSolid(vec2 uv) {
-                   if (obstaclesEnabled == 0) return 0.0;
-                   return step(obstacleThreshold, obstacleMask(uv));
+                   return float(obstacleBits(uv) & 1);
                  }
 
                  void main() {
@@ -165,4 +208,7 @@ protected:
                  }
                  );
   }
+
+private:
+  bool footprintOnly = false;
 };
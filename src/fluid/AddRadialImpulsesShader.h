@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "Shader.h"
+#include "AddRadialImpulseShader.h"
+#include "ofGraphics.h"
+#include "ofMesh.h"
+
+// Batched version of AddRadialImpulseShader: injects up to MAX_IMPULSES impulses into the
+// velocities ping-pong FBO in a single full-field pass. Larger batches are split into chunks.
+class AddRadialImpulsesShader : public Shader {
+
+public:
+  // Must match the uniform array sizes in the fragment shader.
+  static constexpr int MAX_IMPULSES = 64;
+
+  // Same units as AddRadialImpulseShader::render: pixels of the velocity field,
+  // velocities as pixels of desired displacement per step.
+  struct RadialImpulse {
+    glm::vec2 centerPx;
+    float radiusPx;
+    glm::vec2 addVelocityPx { 0.0f, 0.0f };
+    float radialVelocityPx = 0.0f;
+    float swirlVelocityPx = 0.0f;
+  };
+
+  // When enabled, each chunk rasterizes only the impulses' bounding rectangles and copies them
+  // back into the source buffer. Overlapping rectangles are harmless: every fragment evaluates the
+  // whole chunk, so both writes agree. Chunks whose footprints cover more than
+  // FOOTPRINT_MAX_COVERAGE of the field fall back to a full pass.
+  void setFootprintOnly(bool footprintOnly_) { footprintOnly = footprintOnly_; }
+  bool isFootprintOnly() const { return footprintOnly; }
+
+  void render(PingPongFbo& velocities, std::span<const RadialImpulse> impulses, float dt) {
+    // Backwards-compatible path: obstacles disabled.
+    render(velocities, impulses, dt, velocities.getSource().getTexture(), false);
+  }
+
+  void render(PingPongFbo& velocities,
+              std::span<const RadialImpulse> impulses,
+              float dt,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
+    if (impulses.empty()) return;
+
+    const auto size = glm::vec2(velocities.getWidth(), velocities.getHeight());
+    const float minDim = std::min(size.x, size.y);
+    const float invMinDim = 1.0f / std::max(1.0f, minDim);
+    const float dtSafe = std::max(dt, 1.0e-6f);
+
+    // Hard safety clamp per impulse, as in AddRadialImpulseShader.
+    const float maxDisp = 1.0f * invMinDim;
+
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+
+    for (size_t first = 0; first < impulses.size(); first += MAX_IMPULSES) {
+      const size_t count = std::min(impulses.size() - first, static_cast<size_t>(MAX_IMPULSES));
+
+      shapes.clear();
+      strengths.clear();
+      footprints.clear();
+      float footprintArea = 0.0f;
+      for (size_t i = first; i < first + count; ++i) {
+        const auto& impulse = impulses[i];
+        if (footprintOnly) {
+          const ofRectangle footprint = AddRadialImpulseShader::getFootprint(impulse.centerPx, impulse.radiusPx, size);
+          if (footprint.width > 0.0f && footprint.height > 0.0f) {
+            footprints.push_back(footprint);
+            footprintArea += footprint.width * footprint.height;
+          }
+        }
+        const glm::vec2 centerUv = impulse.centerPx / size;
+        const glm::vec2 addVelocityUv = (impulse.addVelocityPx / size) / dtSafe;
+        shapes.insert(shapes.end(), { centerUv.x, centerUv.y, impulse.radiusPx * invMinDim, 0.0f });
+        strengths.insert(strengths.end(), { addVelocityUv.x,
+                                            addVelocityUv.y,
+                                            (impulse.radialVelocityPx * invMinDim) / dtSafe,
+                                            (impulse.swirlVelocityPx * invMinDim) / dtSafe });
+      }
+
+      const bool useFootprints = footprintOnly && footprintArea <= FOOTPRINT_MAX_COVERAGE * size.x * size.y;
+      if (useFootprints && footprints.empty()) continue;
+
+      OFXRENDERER_GL_COUNT(fboBinds, 2);
+      velocities.getTarget().begin();
+      shader.begin();
+      shader.setUniformTexture("tex0", velocities.getSource().getTexture(), 0);
+      shader.setUniformTexture("obstacles", obstacleMask, 1);
+      shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
+      shader.setUniform1i("impulseCount", static_cast<int>(count));
+      shader.setUniform4fv("impulseShapes", shapes.data(), static_cast<int>(count));
+      shader.setUniform4fv("impulseStrengths", strengths.data(), static_cast<int>(count));
+      shader.setUniform1f("dt", dt);
+      shader.setUniform1f("maxDisp", maxDisp);
+      if (useFootprints) {
+        buildFootprintMesh(size);
+        OFXRENDERER_GL_COUNT(drawCalls, 1);
+        footprintMesh.draw();
+      } else {
+        OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
+        velocities.getSource().draw(0, 0);
+      }
+      shader.end();
+      velocities.getTarget().end();
+      if (useFootprints) {
+        for (const auto& footprint : footprints) {
+          velocities.copyTargetRegionToSource(footprint);
+        }
+      } else {
+        velocities.swap();
+      }
+    }
+
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                 uniform sampler2D tex0; // previous velocities
+                 uniform sampler2D obstacles; // ObstacleMaskRenderer output
+                 uniform int obstaclesEnabled;
+                 uniform int impulseCount;
+                 uniform vec4 impulseShapes[64];    // xy = center (UV), z = radius (UV)
+                 uniform vec4 impulseStrengths[64]; // xy = addVelocity, z = radialStrength, w = swirlStrength
+                 uniform float dt;
+                 uniform float maxDisp; // UV units (domain lengths)
+                 in vec2 texCoordVarying;
+                 out vec4 fragColor;
+
+                 // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                 int obstacleBits(vec2 uv) {
+                   if (obstaclesEnabled == 0) return 0;
+                   return int(texture(obstacles, uv).r * 255.0 + 0.5);
+                 }
+
+                 float obstacleSolid(vec2 uv) {
+                   return float(obstacleBits(uv) & 1);
+                 }
+
+                 void main() {
+                   vec2 uv = texCoordVarying.xy;
+
+                   if (obstacleSolid(uv) > 0.5) {
+                     fragColor = vec4(0.0);
+                     return;
+                   }
+
+                   vec2 v = texture(tex0, uv).xy;
+
+                   // Apply impulses in order, clamping after each one so the result matches
+                   // a sequence of single AddRadialImpulseShader passes.
+                   for (int i = 0; i < impulseCount; ++i) {
+                     vec4 shape = impulseShapes[i];
+                     vec2 d = uv - shape.xy;
+                     float dist = length(d);
+                     if (dist >= shape.z) continue;
+
+                     float t = clamp(dist / shape.z, 0.0, 1.0);
+                     float fade = 1.0 - smoothstep(0.0, 1.0, t);
+
+                     vec2 dir = dist > 0.0 ? normalize(d) : vec2(0.0);
+                     vec2 tangent = vec2(-dir.y, dir.x);
+
+                     vec4 s = impulseStrengths[i];
+                     v += (s.xy + dir * s.z + tangent * s.w) * fade;
+
+                     float disp = length(v) * dt;
+                     if (disp > maxDisp && disp > 0.0) {
+                       v *= maxDisp / disp;
+                     }
+                   }
+
+                   fragColor = vec4(v, 0.0, 0.0);
+                 }
+                 );
+  }
+
+private:
+  static constexpr float FOOTPRINT_MAX_COVERAGE = 0.5f;
+
+  void buildFootprintMesh(glm::vec2 size) {
+    footprintMesh.clear();
+    footprintMesh.setMode(OF_PRIMITIVE_TRIANGLES);
+    for (const auto& footprint : footprints) {
+      const glm::vec2 lo { footprint.x, footprint.y };
+      const glm::vec2 hi { footprint.x + footprint.width, footprint.y + footprint.height };
+      const glm::vec2 corners[4] = { lo, { hi.x, lo.y }, { lo.x, hi.y }, hi };
+      const auto firstIndex = static_cast<ofIndexType>(footprintMesh.getNumVertices());
+      for (const auto& corner : corners) {
+        footprintMesh.addVertex(glm::vec3(corner, 0.0f));
+        footprintMesh.addTexCoord(corner / size);
+      }
+      footprintMesh.addIndices({ firstIndex, firstIndex + 1, firstIndex + 2, firstIndex + 1, firstIndex + 3, firstIndex + 2 });
+    }
+  }
+
+  bool footprintOnly = false;
+  std::vector<float> shapes;
+  std::vector<float> strengths;
+  std::vector<ofRectangle> footprints;
+  ofMesh footprintMesh;
+};
@@ -1,11 +1,16 @@
 #pragma once
 
 #include "Shader.h"
+#include "ObstacleMaskRenderer.h"
 #include "ofUtils.h"
 
 class AdvectShader : public Shader {
 
 public:
+  // Velocity advection only: also applies the solid-wall boundary in the same pass, which saves
+  // the separate VelocityBoundaryShader pass.
+  void setFusedWallBoundary(bool fusedWallBoundary_) { fusedWallBoundary = fusedWallBoundary_; }
+
   void render(PingPongFbo& values, const ofTexture& velocities, float dt, float dissipation, float maxValue = 0.0f) {
     // Backwards-compatible path: obstacles disabled.
     render(values,
@@ -14,11 +19,11 @@ public:
            dissipation,
            maxValue,
            values.getSource().getTexture(),
-           false,
-           0.5f,
            false);
   }
 
+  // Thresholds obstacles into a mask on every call; see ObstacleMaskRenderer::buildShared().
+  [[deprecated("pass an ObstacleMaskRenderer mask and obstaclesEnabled instead")]]
   void render(PingPongFbo& values,
               const ofTexture& velocities,
               float dt,
@@ -28,24 +33,37 @@ public:
               bool obstaclesEnabled,
               float obstacleThreshold,
               bool obstacleInvert) {
+    render(values,
+           velocities,
+           dt,
+           dissipation,
+           maxValue,
+           obstaclesEnabled ? ObstacleMaskRenderer::buildShared(obstacles, values.getWidth(), values.getHeight(), obstacleThreshold, obstacleInvert) : obstacles,
+           obstaclesEnabled);
+  }
+
+  void render(PingPongFbo& values,
+              const ofTexture& velocities,
+              float dt,
+              float dissipation,
+              float maxValue,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
-    values.getTarget().begin();
     shader.begin();
     {
       shader.setUniformTexture("tex0", values.getSource().getTexture(), 1);
       shader.setUniformTexture("velocities", velocities, 2);
-      shader.setUniformTexture("obstacles", obstacles, 3);
+      shader.setUniformTexture("obstacles", obstacleMask, 3);
       shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
-      shader.setUniform1f("obstacleThreshold", obstacleThreshold);
-      shader.setUniform1i("obstacleInvert", obstacleInvert ? 1 : 0);
       shader.setUniform1f("dt", dt);
       shader.setUniform1f("dissipation", dissipation);
       shader.setUniform1f("maxValue", maxValue);
-      values.getSource().draw(0, 0);
+      shader.setUniform1i("wallBoundary", fusedWallBoundary ? 1 : 0);
+      drawPass(values.getTarget(), values.getSource().getTexture());
     }
     shader.end();
-    values.getTarget().end();
     values.swap();
     ofPopStyle();
   }
@@ -59,29 +77,23 @@ protected:
     return GLSL(
                 uniform sampler2D tex0; // previous values
                 uniform sampler2D velocities;
-                uniform sampler2D obstacles;
+                uniform sampler2D obstacles; // ObstacleMaskRenderer output
                 uniform int obstaclesEnabled;
-                uniform float obstacleThreshold;
-                uniform int obstacleInvert;
                 uniform float dt;
                 uniform float dissipation;
                 uniform float maxValue;
+                uniform int wallBoundary;
                 in vec2 texCoordVarying;
                 out vec4 fragColor;
 
-                float obstacleMask(vec2 uv) {
-                  // Sample obstacles at texel centers to avoid linear-filter "bleed" at boundaries.
-                  vec2 sz = vec2(textureSize(obstacles, 0));
-                  vec2 uvQ = (floor(uv * sz) + 0.5) / sz;
-                  vec4 o = texture(obstacles, uvQ);
-                  float m = max(o.a, dot(o.rgb, vec3(0.333333)));
-                  if (obstacleInvert == 1) m = 1.0 - m;
-                  return m;
+                // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                int obstacleBits(vec2 uv) {
+                  if (obstaclesEnabled == 0) return 0;
+                  return int(texture(obstacles, uv).r * 255.0 + 0.5);
                 }
 
                 float obstacleSolid(vec2 uv) {
-                  if (obstaclesEnabled == 0) return 0.0;
-                  return step(obstacleThreshold, obstacleMask(uv));
+                  return float(obstacleBits(uv) & 1);
                 }
 
                 vec4 sampleMasked(sampler2D tex, vec2 uv) {
@@ -119,6 +131,16 @@ protected:
                   return (c00 * w00 + c10 * w10 + c01 * w01 + c11 * w11) / wSum;
                 }
 
+                // As VelocityBoundaryShader: zero the wall-normal velocity on the outermost texels.
+                vec4 applyWalls(vec4 c, vec2 uv) {
+                  if (wallBoundary == 0) return c;
+                  vec2 texSize = vec2(textureSize(tex0, 0));
+                  vec2 p = uv * texSize;
+                  if (p.x < 1.5 || p.x > texSize.x - 1.5) c.x = 0.0;
+                  if (p.y < 1.5 || p.y > texSize.y - 1.5) c.y = 0.0;
+                  return vec4(c.xy, 0.0, 0.0);
+                }
+
                 void main() {
                   vec2 xy = texCoordVarying.xy;
 
@@ -138,7 +160,12 @@ protected:
                   if (maxValue > 0.0) {
                     fragColor = clamp(fragColor, vec4(0.0), vec4(maxValue));
                   }
+
+                  fragColor = applyWalls(fragColor, xy);
                 }
                 );
   }
+
+private:
+  bool fusedWallBoundary = false;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Shader.h"
+#include "ObstacleMaskRenderer.h"
 #include "ofGraphics.h"
 
 class ApplyBouyancyShader : public Shader {
@@ -24,11 +25,11 @@ public:
            gravityForceX,
            gravityForceY,
            velocities.getSource().getTexture(),
-           false,
-           0.5f,
            false);
   }
 
+  // Thresholds obstacles into a mask on every call; see ObstacleMaskRenderer::buildShared().
+  [[deprecated("pass an ObstacleMaskRenderer mask and obstaclesEnabled instead")]]
   void render(PingPongFbo& velocities,
               const PingPongFbo& values,
               float dt,
@@ -41,12 +42,33 @@ public:
               bool obstaclesEnabled,
               float obstacleThreshold,
               bool obstacleInvert) {
+    render(velocities,
+           values,
+           dt,
+           buoyancyStrength,
+           densityScale,
+           densityThreshold,
+           gravityForceX,
+           gravityForceY,
+           obstaclesEnabled ? ObstacleMaskRenderer::buildShared(obstacles, velocities.getWidth(), velocities.getHeight(), obstacleThreshold, obstacleInvert) : obstacles,
+           obstaclesEnabled);
+  }
+
+  void render(PingPongFbo& velocities,
+              const PingPongFbo& values,
+              float dt,
+              float buoyancyStrength,
+              float densityScale,
+              float densityThreshold,
+              float gravityForceX,
+              float gravityForceY,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
     if (buoyancyStrength == 0.0f) return;
 
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
 
-    velocities.getTarget().begin();
     {
       shader.begin();
       shader.setUniform1f("dt", dt);
@@ -55,14 +77,11 @@ public:
       shader.setUniform1f("densityThreshold", densityThreshold);
       shader.setUniform2f("gravityForce", gravityForceX, gravityForceY);
       shader.setUniformTexture("values", values.getSource().getTexture(), 1);
-      shader.setUniformTexture("obstacles", obstacles, 2);
+      shader.setUniformTexture("obstacles", obstacleMask, 2);
       shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
-      shader.setUniform1f("obstacleThreshold", obstacleThreshold);
-      shader.setUniform1i("obstacleInvert", obstacleInvert ? 1 : 0);
-      velocities.getSource().draw(0, 0);
+      drawPass(velocities.getTarget(), velocities.getSource().getTexture());
       shader.end();
     }
-    velocities.getTarget().end();
     velocities.swap();
 
     ofPopStyle();
@@ -93,10 +112,8 @@ protected:
     return GLSL(
                  uniform sampler2D tex0; // velocities
                  uniform sampler2D values;
-                 uniform sampler2D obstacles;
+                 uniform sampler2D obstacles; // ObstacleMaskRenderer output
                  uniform int obstaclesEnabled;
-                 uniform float obstacleThreshold;
-                 uniform int obstacleInvert;
                  uniform float dt;
                  uniform float buoyancyStrength;
                  uniform float densityScale;
@@ -105,19 +122,14 @@ protected:
                  in vec2 texCoordVarying;
                  out vec4 fragColor;
 
-                 float obstacleMask(vec2 uv) {
-                   // Sample obstacles at texel centers to avoid linear-filter bleed at boundaries.
-                   vec2 sz = vec2(textureSize(obstacles, 0));
-                   vec2 uvQ = (floor(uv * sz) + 0.5) / sz;
-                   vec4 o = texture(obstacles, uvQ);
-                   float m = max(o.a, dot(o.rgb, vec3(0.333333)));
-                   if (obstacleInvert == 1) m = 1.0 - m;
-                   return m;
+                 // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                 int obstacleBits(vec2 uv) {
+                   if (obstaclesEnabled == 0) return 0;
+                   return int(texture(obstacles, uv).r * 255.0 + 0.5);
                  }
 
                  float obstacleSolid(vec2 uv) {
-                   if (obstaclesEnabled == 0) return 0.0;
-                   return step(obstacleThreshold, obstacleMask(uv));
+                   return float(obstacleBits(uv) & 1);
                  }
 
                  void main() {
@@ -31,6 +31,7 @@ public:
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
 
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     velocities.getTarget().begin();
     shader.begin();
     shader.setUniformTexture("tex0", velocities.getSource().getTexture(), 0);
@@ -40,6 +41,7 @@ public:
     shader.setUniform1f("obstacleThreshold", obstacleThreshold);
     shader.setUniform1i("obstacleInvert", obstacleInvert ? 1 : 0);
     shader.setUniform1f("fieldScale", fieldScale);
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     velocities.getSource().draw(0, 0);
     shader.end();
     velocities.getTarget().end();
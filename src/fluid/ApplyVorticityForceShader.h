@@ -3,15 +3,18 @@
 #include <algorithm>
 
 #include "Shader.h"
+#include "ObstacleMaskRenderer.h"
 
 class ApplyVorticityForceShader : public Shader {
 
 public:
   void render(PingPongFbo& velocities_, ofFbo& curls_, float vorticityStrength_, float dt_) {
     // Backwards-compatible path: obstacles disabled.
-    render(velocities_, curls_, vorticityStrength_, dt_, velocities_.getSource().getTexture(), false, 0.5f, false);
+    render(velocities_, curls_, vorticityStrength_, dt_, velocities_.getSource().getTexture(), false);
   }
 
+  // Thresholds obstacles into a mask on every call; see ObstacleMaskRenderer::buildShared().
+  [[deprecated("pass an ObstacleMaskRenderer mask and obstaclesEnabled instead")]]
   void render(PingPongFbo& velocities_,
               ofFbo& curls_,
               float vorticityStrength_,
@@ -20,26 +23,36 @@ public:
               bool obstaclesEnabled,
               float obstacleThreshold,
               bool obstacleInvert) {
+    render(velocities_,
+           curls_,
+           vorticityStrength_,
+           dt_,
+           obstaclesEnabled ? ObstacleMaskRenderer::buildShared(obstacles, velocities_.getWidth(), velocities_.getHeight(), obstacleThreshold, obstacleInvert) : obstacles,
+           obstaclesEnabled);
+  }
+
+  void render(PingPongFbo& velocities_,
+              ofFbo& curls_,
+              float vorticityStrength_,
+              float dt_,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
-    velocities_.getTarget().begin();
     {
       shader.begin();
       const auto texSize = glm::vec2(velocities_.getWidth(), velocities_.getHeight());
       shader.setUniformTexture("curls", curls_.getTexture(), 1);
-      shader.setUniformTexture("obstacles", obstacles, 2);
+      shader.setUniformTexture("obstacles", obstacleMask, 2);
       shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
-      shader.setUniform1f("obstacleThreshold", obstacleThreshold);
-      shader.setUniform1i("obstacleInvert", obstacleInvert ? 1 : 0);
       shader.setUniform2f("texSize", texSize);
       shader.setUniform2f("halfInvCell", 0.5f * texSize);
       shader.setUniform1f("vorticityStrength", vorticityStrength_);
       shader.setUniform1f("dt", dt_);
       ofSetColor(255);
-      velocities_.getSource().draw(0, 0);
+      drawPass(velocities_.getTarget(), velocities_.getSource().getTexture());
       shader.end();
     }
-    velocities_.getTarget().end();
     velocities_.swap();
     ofPopStyle();
   }
@@ -49,10 +62,8 @@ protected:
     return GLSL(
                 uniform sampler2D tex0; // velocities
                 uniform sampler2D curls;
-                uniform sampler2D obstacles;
+                uniform sampler2D obstacles; // ObstacleMaskRenderer output
                 uniform int obstaclesEnabled;
-                uniform float obstacleThreshold;
-                uniform int obstacleInvert;
                 uniform vec2 texSize;
                 uniform vec2 halfInvCell;
                 uniform float dt;
@@ -60,19 +71,14 @@ protected:
                 in vec2 texCoordVarying;
                 out vec4 fragColor;
 
-                float obstacleMask(vec2 uv) {
-                  // Sample obstacles at texel centers to avoid linear-filter bleed at boundaries.
-                  vec2 sz = vec2(textureSize(obstacles, 0));
-                  vec2 uvQ = (floor(uv * sz) + 0.5) / sz;
-                  vec4 o = texture(obstacles, uvQ);
-                  float m = max(o.a, dot(o.rgb, vec3(0.333333)));
-                  if (obstacleInvert == 1) m = 1.0 - m;
-                  return m;
+                // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                int obstacleBits(vec2 uv) {
+                  if (obstaclesEnabled == 0) return 0;
+                  return int(texture(obstacles, uv).r * 255.0 + 0.5);
                 }
 
                 float obstacleSolid(vec2 uv) {
-                  if (obstaclesEnabled == 0) return 0.0;
-                  return step(obstacleThreshold, obstacleMask(uv));
+                  return float(obstacleBits(uv) & 1);
                 }
 
                 void main(){
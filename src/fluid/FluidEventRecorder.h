@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "FluidSimulation.h"
+
+// Append-only binary log of a FluidSimulation's inputs: impulses, temperature impulses and
+// parameter overrides, each frame closed by an update record carrying the frame number, the
+// elapsed time, the clock's frame dt, and the frame dt and step count the simulation actually
+// stepped by. FluidEventReplay feeds a log back.
+//
+// Layout (native byte order): char magic[8] = "OFXFEVTS", uint32 version, then records of
+// uint8 type, uint32 payload bytes, payload (floats unless noted below).
+//   UPDATE:               uint64 frame, double elapsedSeconds, float rawFrameDt, float frameDt, int32 steps
+//                         (version 1: no frameDt or steps)
+//   IMPULSE:              one impulse (IMPULSE_FLOATS floats)
+//   IMPULSES:             uint32 count, count impulses
+//   TEMPERATURE_IMPULSE:  x, y, radius, delta
+//   PARAMETER_OVERRIDES:  uint32 presence bits (dt, vorticity, value dissipation, velocity dissipation), 4 floats
+class FluidEventRecorder : public FluidSimulation::InputListener {
+
+public:
+  enum RecordType : uint8_t {
+    UPDATE = 1,
+    IMPULSE = 2,
+    IMPULSES = 3,
+    TEMPERATURE_IMPULSE = 4,
+    PARAMETER_OVERRIDES = 5,
+  };
+
+  static constexpr char MAGIC[8] = { 'O', 'F', 'X', 'F', 'E', 'V', 'T', 'S' };
+  static constexpr uint32_t VERSION = 2;
+  static constexpr size_t IMPULSE_FLOATS = 12;
+
+  FluidEventRecorder() {}
+
+  ~FluidEventRecorder() { close(); }
+
+  FluidEventRecorder(const FluidEventRecorder&) = delete;
+  FluidEventRecorder& operator=(const FluidEventRecorder&) = delete;
+
+  // Starts (or continues) the log at path and attaches to simulation until close().
+  bool open(const std::string& path, FluidSimulation& simulation_) {
+    close();
+    file = std::fopen(path.c_str(), "a+b");
+    if (!file) {
+      ofLogError("FluidEventRecorder") << "can't open " << path;
+      return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    if (std::ftell(file) == 0) {
+      std::fwrite(MAGIC, sizeof(MAGIC), 1, file);
+      std::fwrite(&VERSION, sizeof(VERSION), 1, file);
+    } else {
+      // Only continue a log of this version; records of another can't be mixed in.
+      char magic[sizeof(MAGIC)] = {};
+      uint32_t version = 0;
+      std::fseek(file, 0, SEEK_SET);
+      const bool matches = std::fread(magic, sizeof(magic), 1, file) == 1
+        && std::fread(&version, sizeof(version), 1, file) == 1
+        && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 && version == VERSION;
+      if (!matches) {
+        ofLogError("FluidEventRecorder") << path << " is not a version " << VERSION << " fluid event log";
+        std::fclose(file);
+        file = nullptr;
+        return false;
+      }
+      std::fseek(file, 0, SEEK_END); // a read can't be followed by a write without a seek
+    }
+    simulation = &simulation_;
+    simulation->setInputListener(this);
+    // Start from the overrides in effect.
+    onParameterOverrides(simulation->getParameterOverrides());
+    return true;
+  }
+
+  void close() {
+    if (simulation) simulation->setInputListener(nullptr);
+    simulation = nullptr;
+    if (file) std::fclose(file);
+    file = nullptr;
+  }
+
+  bool isOpen() const { return file != nullptr; }
+
+  void onUpdate(float rawFrameDt, float frameDt, int steps) override {
+    payload.clear();
+    append(static_cast<uint64_t>(ofGetFrameNum()));
+    append(static_cast<double>(ofGetElapsedTimef()));
+    append(rawFrameDt);
+    append(frameDt);
+    append(static_cast<int32_t>(steps));
+    writeRecord(UPDATE);
+    // One flush per frame keeps the log usable if the process dies.
+    if (file) std::fflush(file);
+  }
+
+  void onImpulse(const FluidSimulation::Impulse& impulse) override {
+    payload.clear();
+    appendImpulse(impulse);
+    writeRecord(IMPULSE);
+  }
+
+  void onImpulses(std::span<const FluidSimulation::Impulse> impulses) override {
+    payload.clear();
+    append(static_cast<uint32_t>(impulses.size()));
+    for (const auto& impulse : impulses) appendImpulse(impulse);
+    writeRecord(IMPULSES);
+  }
+
+  void onTemperatureImpulse(glm::vec2 positionPx, float radiusPx, float temperatureDelta) override {
+    payload.clear();
+    append(positionPx.x);
+    append(positionPx.y);
+    append(radiusPx);
+    append(temperatureDelta);
+    writeRecord(TEMPERATURE_IMPULSE);
+  }
+
+  void onParameterOverrides(const FluidSimulation::ParameterOverrides& overrides) override {
+    payload.clear();
+    const uint32_t presence = (overrides.dt ? 1u : 0u)
+      | (overrides.vorticity ? 2u : 0u)
+      | (overrides.valueAdvectDissipation ? 4u : 0u)
+      | (overrides.velocityAdvectDissipation ? 8u : 0u);
+    append(presence);
+    append(overrides.dt.value_or(0.0f));
+    append(overrides.vorticity.value_or(0.0f));
+    append(overrides.valueAdvectDissipation.value_or(0.0f));
+    append(overrides.velocityAdvectDissipation.value_or(0.0f));
+    writeRecord(PARAMETER_OVERRIDES);
+  }
+
+private:
+  template<typename T>
+  void append(T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    payload.insert(payload.end(), bytes, bytes + sizeof(T));
+  }
+
+  void appendImpulse(const FluidSimulation::Impulse& impulse) {
+    const float values[IMPULSE_FLOATS] = {
+      impulse.position.x, impulse.position.y, impulse.radius,
+      impulse.velocity.x, impulse.velocity.y, impulse.radialVelocity, impulse.swirlVelocity,
+      impulse.color.r, impulse.color.g, impulse.color.b, impulse.color.a, impulse.colorDensity,
+    };
+    for (float value : values) append(value);
+  }
+
+  void writeRecord(RecordType type) {
+    if (!file) return;
+    const uint8_t typeByte = type;
+    const uint32_t bytes = static_cast<uint32_t>(payload.size());
+    std::fwrite(&typeByte, sizeof(typeByte), 1, file);
+    std::fwrite(&bytes, sizeof(bytes), 1, file);
+    std::fwrite(payload.data(), 1, payload.size(), file);
+  }
+
+  FILE* file = nullptr;
+  FluidSimulation* simulation = nullptr;
+  std::vector<uint8_t> payload;
+};
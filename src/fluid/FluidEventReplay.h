@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "FluidEventRecorder.h"
+
+// Feeds a FluidEventRecorder log back into a FluidSimulation, one recorded frame at a time.
+// Each frame takes the recorded number of steps at the recorded frame dt, through the same
+// path as update() (FluidSimulation::stepFrame()), and its impulses scale by that dt. A replay
+// is the recorded workload, whatever the host's frame pacing, so it can be timed or compared
+// against the original run (e.g. from a headless app). The simulation's parameters should match
+// the recording's; only the overrides are in the log.
+class FluidEventReplay {
+
+public:
+  struct Frame {
+    uint64_t frame = 0;          // as recorded
+    double elapsedSeconds = 0.0; // as recorded
+    float rawFrameDt = 0.0f;     // as recorded
+    float frameDt = 0.0f;        // the dt the frame's steps used
+    int steps = 0;               // steps the frame ran
+  };
+
+  bool open(const std::string& path) {
+    data.clear();
+    cursor = 0;
+    frameCount = 0;
+
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+      ofLogError("FluidEventReplay") << "can't open " << path;
+      return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long length = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if (length > 0) {
+      data.resize(static_cast<size_t>(length));
+      if (std::fread(data.data(), 1, data.size(), file) != data.size()) data.clear();
+    }
+    std::fclose(file);
+
+    uint32_t version = 0;
+    constexpr size_t HEADER_BYTES = sizeof(FluidEventRecorder::MAGIC) + sizeof(version);
+    if (data.size() < HEADER_BYTES || std::memcmp(data.data(), FluidEventRecorder::MAGIC, sizeof(FluidEventRecorder::MAGIC)) != 0) {
+      ofLogError("FluidEventReplay") << path << " is not a fluid event log";
+      data.clear();
+      return false;
+    }
+    std::memcpy(&version, data.data() + sizeof(FluidEventRecorder::MAGIC), sizeof(version));
+    if (version != 1 && version != FluidEventRecorder::VERSION) {
+      ofLogError("FluidEventReplay") << path << " has unsupported version " << version;
+      data.clear();
+      return false;
+    }
+    cursor = HEADER_BYTES;
+    logVersion = version;
+    return true;
+  }
+
+  // Applies the next frame's inputs to simulation, then steps it as the recorded frame did.
+  // Version 1 logs don't record the steps, so their frames replay as one step of the clamped
+  // recorded frame dt, as update() does without "Fixed Step".
+  // Returns false at the end of the log (a trailing frame without its update record is dropped).
+  bool replayFrame(FluidSimulation& simulation) {
+    // The update record closes the frame, but the impulses before it need its dt.
+    Frame frame;
+    if (!findUpdate(frame)) return false;
+    simulation.setImpulseFrameDt(frame.frameDt);
+
+    uint8_t type = 0;
+    const uint8_t* payload = nullptr;
+    uint32_t bytes = 0;
+    while (readRecord(cursor, type, payload, bytes)) {
+      switch (type) {
+        case FluidEventRecorder::UPDATE:
+          lastFrame = frame;
+          simulation.stepFrame(frame.frameDt, frame.steps);
+          ++frameCount;
+          return true;
+        case FluidEventRecorder::IMPULSE:
+          if (bytes == IMPULSE_BYTES) simulation.applyImpulse(readImpulse(payload));
+          break;
+        case FluidEventRecorder::IMPULSES:
+          replayImpulses(simulation, payload, bytes);
+          break;
+        case FluidEventRecorder::TEMPERATURE_IMPULSE:
+          if (bytes == 4 * sizeof(float)) {
+            float values[4];
+            std::memcpy(values, payload, sizeof(values));
+            simulation.applyTemperatureImpulse({ values[0], values[1] }, values[2], values[3]);
+          }
+          break;
+        case FluidEventRecorder::PARAMETER_OVERRIDES:
+          replayParameterOverrides(simulation, payload, bytes);
+          break;
+        default:
+          break; // unknown records are skipped
+      }
+    }
+    return false;
+  }
+
+  // Replays the whole log from the current position. Returns the number of frames stepped.
+  size_t replayAll(FluidSimulation& simulation) {
+    const size_t first = frameCount;
+    while (replayFrame(simulation)) {}
+    return frameCount - first;
+  }
+
+  // The most recently replayed frame's recorded timing.
+  const Frame& getLastFrame() const { return lastFrame; }
+  size_t getFrameCount() const { return frameCount; }
+
+private:
+  static constexpr size_t IMPULSE_BYTES = FluidEventRecorder::IMPULSE_FLOATS * sizeof(float);
+
+  // Reads the record at position and moves position past it. False at the end of the data or
+  // on a truncated record.
+  bool readRecord(size_t& position, uint8_t& type, const uint8_t*& payload, uint32_t& bytes) const {
+    if (data.size() - position < sizeof(type) + sizeof(bytes)) return false;
+    std::memcpy(&type, data.data() + position, sizeof(type));
+    std::memcpy(&bytes, data.data() + position + sizeof(type), sizeof(bytes));
+    const size_t payloadStart = position + sizeof(type) + sizeof(bytes);
+    if (data.size() - payloadStart < bytes) return false;
+    payload = data.data() + payloadStart;
+    position = payloadStart + bytes;
+    return true;
+  }
+
+  // Reads the next update record without consuming anything.
+  bool findUpdate(Frame& frame) const {
+    size_t position = cursor;
+    uint8_t type = 0;
+    const uint8_t* payload = nullptr;
+    uint32_t bytes = 0;
+    while (readRecord(position, type, payload, bytes)) {
+      if (type != FluidEventRecorder::UPDATE) continue;
+      constexpr size_t V1_BYTES = sizeof(uint64_t) + sizeof(double) + sizeof(float);
+      if (bytes < V1_BYTES) return false;
+      std::memcpy(&frame.frame, payload, sizeof(uint64_t));
+      std::memcpy(&frame.elapsedSeconds, payload + sizeof(uint64_t), sizeof(double));
+      std::memcpy(&frame.rawFrameDt, payload + sizeof(uint64_t) + sizeof(double), sizeof(float));
+      if (logVersion == 1) {
+        frame.frameDt = FluidSimulation::clampFrameDt(frame.rawFrameDt);
+        frame.steps = 1;
+        return true;
+      }
+      int32_t steps = 0;
+      if (bytes < V1_BYTES + sizeof(float) + sizeof(steps)) return false;
+      std::memcpy(&frame.frameDt, payload + V1_BYTES, sizeof(float));
+      std::memcpy(&steps, payload + V1_BYTES + sizeof(float), sizeof(steps));
+      frame.steps = steps;
+      return true;
+    }
+    return false;
+  }
+
+  static FluidSimulation::Impulse readImpulse(const uint8_t* payload) {
+    float v[FluidEventRecorder::IMPULSE_FLOATS];
+    std::memcpy(v, payload, sizeof(v));
+    FluidSimulation::Impulse impulse;
+    impulse.position = { v[0], v[1] };
+    impulse.radius = v[2];
+    impulse.velocity = { v[3], v[4] };
+    impulse.radialVelocity = v[5];
+    impulse.swirlVelocity = v[6];
+    impulse.color = ofFloatColor { v[7], v[8], v[9], v[10] };
+    impulse.colorDensity = v[11];
+    return impulse;
+  }
+
+  void replayImpulses(FluidSimulation& simulation, const uint8_t* payload, uint32_t bytes) {
+    uint32_t count = 0;
+    if (bytes < sizeof(count)) return;
+    std::memcpy(&count, payload, sizeof(count));
+    if (bytes != sizeof(count) + uint64_t(count) * IMPULSE_BYTES) return;
+    impulses.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+      impulses.push_back(readImpulse(payload + sizeof(count) + i * IMPULSE_BYTES));
+    }
+    simulation.applyImpulses(impulses);
+  }
+
+  static void replayParameterOverrides(FluidSimulation& simulation, const uint8_t* payload, uint32_t bytes) {
+    uint32_t presence = 0;
+    float values[4];
+    if (bytes != sizeof(presence) + sizeof(values)) return;
+    std::memcpy(&presence, payload, sizeof(presence));
+    std::memcpy(values, payload + sizeof(presence), sizeof(values));
+    FluidSimulation::ParameterOverrides overrides;
+    if (presence & 1u) overrides.dt = values[0];
+    if (presence & 2u) overrides.vorticity = values[1];
+    if (presence & 4u) overrides.valueAdvectDissipation = values[2];
+    if (presence & 8u) overrides.velocityAdvectDissipation = values[3];
+    simulation.setParameterOverrides(overrides);
+  }
+
+  std::vector<uint8_t> data;
+  size_t cursor = 0;
+  uint32_t logVersion = 0;
+  size_t frameCount = 0;
+  Frame lastFrame;
+  std::vector<FluidSimulation::Impulse> impulses;
+};
@@ -2,9 +2,14 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "ofAppRunner.h" // ofGetLastFrameTime()
 #include "ofFbo.h"
@@ -15,6 +20,10 @@
 #include "PingPongFbo.h"
 #include "AdvectShader.h"
 #include "JacobiShader.h"
+#include "RedBlackSorShader.h"
+#include "PoissonMultigridSolver.h"
+#include "PoissonResidualShader.h"
+#include "FieldReduction.h"
 #include "DivergenceRenderer.h"
 #include "SubtractDivergenceShader.h"
 #include "VorticityRenderer.h"
@@ -23,7 +32,15 @@
 #include "VelocityCflClampShader.h"
 #include "ApplyBouyancyShader.h"
 #include "ApplyTemperatureBuoyancyShader.h"
+#include "FusedForcesShader.h"
+#include "ObstacleMaskRenderer.h"
+#include "TileActivityShader.h"
+#include "TileCoverage.h"
+#include "PboReadback.h"
+#include "GpuTimerPool.h"
+#include "FluidStateFile.h"
 #include "AddRadialImpulseShader.h"
+#include "AddRadialImpulsesShader.h"
 #include "SoftCircleShader.h"
 
 // https://developer.nvidia.com/gpugems/gpugems/part-vi-beyond-triangles/chapter-38-fast-fluid-dynamics-simulation-gpu
@@ -90,6 +107,45 @@ public:
     float temperatureDissipation = 1.0f;
     float temperatureSpreadCoeff = 0.0f;
     float vorticityStrength = 0.0f;
+    // Full-resolution pressure smoothing passes; -1 if not known yet. With "Pressure Adaptive"
+    // this is the count from the most recent solve whose queries have completed (a frame or two
+    // late), so it stays -1 until the first one has; otherwise it is set by every step.
+    int pressureIterations = -1;
+    // Pressure residual |divergence - Laplacian(pressure)| after the solve, when
+    // "Pressure Residual" is enabled. Read back asynchronously, so it lags by a frame or two.
+    bool pressureResidualValid = false;
+    float pressureResidualMax = 0.0f;
+    float pressureResidualRms = 0.0f;
+    // True when this update rebuilt the obstacle mask.
+    bool obstacleMaskRebuilt = false;
+    // "Sleep Enabled": whether this update skipped the solver, and the most recent measured
+    // max velocity in cells per step (read back asynchronously, a frame or two late).
+    bool asleep = false;
+    float sleepMaxDisplacement = 0.0f;
+    // "Tiled": tiles the solver rasterized this step, out of the whole grid.
+    int activeTiles = 0;
+    int totalTiles = 0;
+    // "CFL Mode": advection substeps this step, and whether the velocity clamp ran.
+    int advectionSubsteps = 1;
+    bool cflClampApplied = true;
+    // Steps this update() ran: 1, or 0..N with "Fixed Step".
+    int fixedSteps = 1;
+  };
+
+  enum PressureSolver {
+    PRESSURE_SOLVER_JACOBI = 0,
+    PRESSURE_SOLVER_MULTIGRID = 1,
+    PRESSURE_SOLVER_RED_BLACK_SOR = 2,
+  };
+
+  enum CflMode {
+    CFL_MODE_CLAMP = 0,
+    CFL_MODE_SUBSTEP = 1,
+  };
+
+  enum DiffusionSolver {
+    DIFFUSION_SOLVER_JACOBI = 0,
+    DIFFUSION_SOLVER_RED_BLACK_SOR = 1,
   };
 
   struct ParameterOverrides {
@@ -108,9 +164,27 @@ public:
   void setParameterOverrides(const ParameterOverrides& overrides) {
     if (parameterOverrides_ == overrides) return;
     parameterOverrides_ = overrides;
+    if (inputListener) inputListener->onParameterOverrides(overrides);
   }
 
   void clearParameterOverrides() { setParameterOverrides({}); }
+  const ParameterOverrides& getParameterOverrides() const { return parameterOverrides_; }
+
+  // Receives the simulation's external inputs as they are applied, e.g. FluidEventRecorder.
+  class InputListener {
+  public:
+    virtual ~InputListener() {}
+    // Once per update() (or stepFrame()), before stepping: the clock's frame time, the frame dt
+    // the steps use and how many steps run.
+    virtual void onUpdate(float rawFrameDt, float frameDt, int steps) = 0;
+    virtual void onImpulse(const Impulse& impulse) = 0;
+    virtual void onImpulses(std::span<const Impulse> impulses) = 0;
+    virtual void onTemperatureImpulse(glm::vec2 positionPx, float radiusPx, float temperatureDelta) = 0;
+    virtual void onParameterOverrides(const ParameterOverrides& overrides) = 0;
+  };
+
+  // Not owned; pass nullptr to detach.
+  void setInputListener(InputListener* inputListener_) { inputListener = inputListener_; }
 
   float getDtEffective() const { return parameterOverrides_.dt.value_or(dtParameter.get()); }
   float getVorticityEffective() const { return parameterOverrides_.vorticity.value_or(vorticityParameter.get()); }
@@ -123,6 +197,47 @@ public:
 
   const DebugStepInfo& getDebugStepInfo() const { return debugStepInfo; }
 
+  // GPU time per stage with "Stage Timing" on, per frame (all steps and calls summed), over a
+  // rolling window. Collected with timestamp queries a few frames late, so it never stalls.
+  // Stages that haven't run are all zero.
+  struct StageTimings {
+    GpuTimerPool::Stats impulses;
+    GpuTimerPool::Stats advectVelocity;
+    GpuTimerPool::Stats advectValues;
+    GpuTimerPool::Stats advectTemperature;
+    GpuTimerPool::Stats diffuseVelocity;
+    GpuTimerPool::Stats diffuseValues;
+    GpuTimerPool::Stats diffuseTemperature;
+    GpuTimerPool::Stats vorticity;
+    GpuTimerPool::Stats buoyancy;
+    GpuTimerPool::Stats fusedForces;
+    GpuTimerPool::Stats divergence;
+    GpuTimerPool::Stats pressure;
+    GpuTimerPool::Stats subtract;
+    GpuTimerPool::Stats boundaries;
+    GpuTimerPool::Stats cflClamp;
+  };
+
+  StageTimings getStageTimings() const {
+    StageTimings timings;
+    timings.impulses = stageTimers.getStats("impulses");
+    timings.advectVelocity = stageTimers.getStats("advectVelocity");
+    timings.advectValues = stageTimers.getStats("advectValues");
+    timings.advectTemperature = stageTimers.getStats("advectTemperature");
+    timings.diffuseVelocity = stageTimers.getStats("diffuseVelocity");
+    timings.diffuseValues = stageTimers.getStats("diffuseValues");
+    timings.diffuseTemperature = stageTimers.getStats("diffuseTemperature");
+    timings.vorticity = stageTimers.getStats("vorticity");
+    timings.buoyancy = stageTimers.getStats("buoyancy");
+    timings.fusedForces = stageTimers.getStats("fusedForces");
+    timings.divergence = stageTimers.getStats("divergence");
+    timings.pressure = stageTimers.getStats("pressure");
+    timings.subtract = stageTimers.getStats("subtract");
+    timings.boundaries = stageTimers.getStats("boundaries");
+    timings.cflClamp = stageTimers.getStats("cflClamp");
+    return timings;
+  }
+
   void resetTemperature() {
     if (!isValid()) return;
     if (!temperaturesFbo.isAllocated()) return;
@@ -132,6 +247,42 @@ public:
   // Clears pressure on next update() (warm-start uses previous pressure otherwise).
   void resetPressure() { pressureNeedsClear = true; }
 
+  // Call after drawing into the obstacles buffer. With "Obstacle Dirty Tracking" enabled the
+  // obstacle mask is only rebuilt after this (or a threshold/invert/boundary change), so a
+  // static obstacle map costs nothing per frame. Without it the mask is rebuilt every update.
+  void markObstaclesDirty() { ++obstaclesGeneration; }
+  uint64_t getObstaclesGeneration() const { return obstaclesGeneration; }
+
+  // With "Sleep Enabled", the solver stops once max |velocity| has stayed below "Sleep Epsilon"
+  // for "Sleep Delay" steps, leaving only value dissipation. Impulses wake it automatically;
+  // call wake() after writing into the velocities from outside the simulation.
+  void wake() {
+    asleep = false;
+    quietSteps = 0;
+    lastWakeStep = stepIndex + 1;
+  }
+  bool isAsleep() const { return asleep; }
+
+  // With "Tiled", only tiles with measured activity are stepped, and tiles that go idle are
+  // zeroed. Call one of these after writing into the values or velocities other than through
+  // the impulse methods (e.g. drawing straight into the fbos), so the written tiles are stepped
+  // and not cleared until a measurement has seen the write. rectPx is in velocity-grid pixels,
+  // like impulse positions. Both also wake().
+  void markRegionActive(const ofRectangle& rectPx) {
+    wake();
+    markWrittenTiles(rectPx);
+  }
+
+  void markAllActive() {
+    wake();
+    std::fill(writtenTiles.begin(), writtenTiles.end(), 1);
+  }
+
+  // Selects how the simulation's fullscreen passes are issued (see Shader::PassMode).
+  // Call before setup(); outputs are identical either way.
+  void setPassMode(Shader::PassMode passMode_) { passMode = passMode_; }
+  Shader::PassMode getPassMode() const { return passMode; }
+
   void setup(glm::vec2 flowValuesSize) {
     ownsFlowBuffers = true;
     lastBoundaryMode = boundaryModeParameter.get();
@@ -168,6 +319,7 @@ public:
     flowValuesFboPtr = std::move(flowValuesFboPtr_);
     flowVelocitiesFboPtr = std::move(flowVelocitiesFboPtr_);
     obstaclesFboPtr = std::move(obstaclesFboPtr_);
+    markObstaclesDirty();
     validateExternalBuffers();
     setupInternals();
   }
@@ -190,6 +342,18 @@ public:
 
     pressuresFbo.allocate(flowVelocitiesSize.x, flowVelocitiesSize.y, GL_RGB32F);
     pressureJacobiShader.load();
+    pressureSorShader.load();
+    diffusionSorShader.load();
+    pressureMultigridSolver.allocate(flowVelocitiesSize.x, flowVelocitiesSize.y, getExpectedWrapMode());
+    pressureMultigridSolver.load();
+    pressureResidualFbo.allocate(createFboSettings(flowVelocitiesSize, GL_R32F));
+    pressureResidualShader.load();
+    pressureResidualReduction.load();
+    velocityReduction.load();
+    allocateTileActivity(flowVelocitiesSize);
+    obstacleMaskRenderer.allocate(flowVelocitiesSize.x, flowVelocitiesSize.y);
+    obstacleMaskRenderer.load();
+    markObstaclesDirty();
 
     subtractDivergenceShader.load();
     
@@ -218,8 +382,12 @@ public:
     applyTemperatureBuoyancyShader.load();
 
     addRadialImpulseShader.load();
+    addRadialImpulsesShader.load();
     softCircleShader.load();
 
+    fusedForcesShader.load();
+
+    applyPassMode();
     applyExpectedWrapModeToInternalBuffers();
     resetPressure();
   }
@@ -237,6 +405,20 @@ public:
       parameters.add(valueSpreadParameter);
       parameters.add(velocitySpreadParameter);
       parameters.add(valueMaxParameter);
+      parameters.add(impulseFootprintParameter);
+      parameters.add(fusedPassesParameter);
+      parameters.add(sleepEnabledParameter);
+      parameters.add(sleepEpsilonParameter);
+      parameters.add(sleepDelayParameter);
+      parameters.add(tiledParameter);
+      parameters.add(tileVelocityEpsilonParameter);
+      parameters.add(tileValueEpsilonParameter);
+      parameters.add(cflModeParameter);
+      parameters.add(maxSubstepsParameter);
+      parameters.add(fixedStepParameter);
+      parameters.add(fixedStepRateParameter);
+      parameters.add(fixedStepMaxStepsParameter);
+      parameters.add(stageTimingParameter);
 
       temperatureParameters.add(temperatureEnabledParameter);
       temperatureParameters.add(temperatureAdvectDissipationParameter);
@@ -247,11 +429,21 @@ public:
       obstaclesParameters.add(obstaclesEnabledParameter);
       obstaclesParameters.add(obstacleThresholdParameter);
       obstaclesParameters.add(obstacleInvertParameter);
+      obstaclesParameters.add(obstacleDirtyTrackingParameter);
       parameters.add(obstaclesParameters);
 
       parameters.add(valueDiffusionIterationsParameter);
       parameters.add(velocityDiffusionIterationsParameter);
       parameters.add(pressureDiffusionIterationsParameter);
+      parameters.add(diffusionSolverParameter);
+      parameters.add(diffusionSorOmegaParameter);
+      parameters.add(pressureSolverParameter);
+      parameters.add(pressureSorOmegaParameter);
+      parameters.add(pressureVCyclesParameter);
+      parameters.add(pressureAdaptiveParameter);
+      parameters.add(pressureToleranceParameter);
+      parameters.add(pressureCheckIntervalParameter);
+      parameters.add(pressureResidualParameter);
       buoyancyParameters.add(buoyancyStrengthParameter);
       buoyancyParameters.add(buoyancyDensityScaleParameter);
       buoyancyParameters.add(buoyancyThresholdParameter);
@@ -266,209 +458,61 @@ public:
   }
   
   void update() {
-    if (!isSetup()) return;
-
-    const int boundaryMode = boundaryModeParameter.get();
-    if (boundaryMode != lastBoundaryMode) {
-      lastBoundaryMode = boundaryMode;
-      resetPressure();
-      validateExternalBuffers();
-    }
-
-    const bool obstaclesEnabled = obstaclesEnabledParameter.get();
-    if (obstaclesEnabled != lastObstaclesEnabled) {
-      lastObstaclesEnabled = obstaclesEnabled;
-      resetPressure();
-      validateExternalBuffers();
-    }
-
-    if (!isValid()) return;
-
-    const bool useObstacles = obstaclesEnabled && obstaclesFboPtr && obstaclesFboPtr->getSource().isAllocated();
-    const ofTexture& obstaclesTex = useObstacles ? obstaclesFboPtr->getSource().getTexture()
-                                                 : flowValuesFboPtr->getSource().getTexture();
-    const float obstacleThreshold = obstacleThresholdParameter.get();
-    const bool obstacleInvert = obstacleInvertParameter.get();
-
     const float rawFrameDt = static_cast<float>(ofGetLastFrameTime());
-    const float frameDt = clampFrameDt(rawFrameDt);
-
-    // dtParameter is tuned relative to a baseline framerate (historically 30fps).
-    // At 30fps, dtEffective ~= dtParameter.
-    // Effective dt used by the solver is: dt = dtParameter * frameDt * BASE_FPS.
-    static constexpr float BASE_FPS = 30.0f;
-    const float dt = getDtEffective() * frameDt * BASE_FPS;
-
-    debugStepInfo.rawFrameDt = rawFrameDt;
-    debugStepInfo.frameDt = frameDt;
-    debugStepInfo.dtEffective = dt;
-
-    const float gridSize = std::min(flowVelocitiesFboPtr->getWidth(), flowVelocitiesFboPtr->getHeight());
-    const float dx = 1.0f / std::max(1.0f, gridSize);
-    debugStepInfo.dx = dx;
-
-    const float velocityDissipation = persistenceToDissipation(getVelocityAdvectDissipationEffective(), frameDt, 0.05f, 6.0f);
-    const float valueDissipation = persistenceToDissipation(getValueAdvectDissipationEffective(), frameDt, 0.2f, 30.0f);
-    debugStepInfo.velocityDissipation = velocityDissipation;
-    debugStepInfo.valueDissipation = valueDissipation;
+    impulseFrameDt.reset();
 
-    // advect
-    velocityAdvectShader.render(*flowVelocitiesFboPtr,
-                                flowVelocitiesFboPtr->getSource().getTexture(),
-                                dt,
-                                velocityDissipation,
-                                0.0f,
-                                obstaclesTex,
-                                useObstacles,
-                                obstacleThreshold,
-                                obstacleInvert);
-    applyVelocityBoundariesIfNeeded();
-
-    valueAdvectShader.render(*flowValuesFboPtr,
-                              flowVelocitiesFboPtr->getSource().getTexture(),
-                              dt,
-                              valueDissipation,
-                              valueMaxParameter.get(),
-                              obstaclesTex,
-                              useObstacles,
-                              obstacleThreshold,
-                              obstacleInvert);
-
-    if (temperatureEnabledParameter.get()) {
-      const float temperatureDissipation = persistenceToDissipation(temperatureAdvectDissipationParameter.get(), frameDt, 0.2f, 30.0f);
-      debugStepInfo.temperatureDissipation = temperatureDissipation;
-
-      temperatureAdvectShader.render(temperaturesFbo,
-                                    flowVelocitiesFboPtr->getSource().getTexture(),
-                                    dt,
-                                    temperatureDissipation,
-                                    0.0f,
-                                    obstaclesTex,
-                                    useObstacles,
-                                    obstacleThreshold,
-                                    obstacleInvert);
-
-      debugStepInfo.temperatureSpreadCoeff = applyDiffusionIfEnabled(temperaturesFbo,
-                                                                    temperatureJacobiShader,
-                                                                    temperatureDiffusionSourceFbo,
-                                                                    temperatureSpreadParameter.get(),
-                                                                    dt,
-                                                                    temperatureDiffusionIterationsParameter.get(),
-                                                                    1.0e-4f,
-                                                                    1500.0f,
-                                                                    obstaclesTex,
-                                                                    useObstacles,
-                                                                    obstacleThreshold,
-                                                                    obstacleInvert);
+    if (!fixedStepParameter.get()) {
+      fixedStepAccumulator = 0.0f;
+      runFrame(rawFrameDt, clampFrameDt(rawFrameDt), 1);
+      return;
     }
 
-    // diffuse (resolution-independent in cell units)
-    debugStepInfo.velocitySpreadCoeff = applyDiffusionIfEnabled(*flowVelocitiesFboPtr,
-                                                               velocityJacobiShader,
-                                                               velocityDiffusionSourceFbo,
-                                                               velocitySpreadParameter.get(),
-                                                               dt,
-                                                               velocityDiffusionIterationsParameter.get(),
-                                                               1.0e-4f,
-                                                               80.0f,
-                                                               obstaclesTex,
-                                                               useObstacles,
-                                                               obstacleThreshold,
-                                                               obstacleInvert);
-    applyVelocityBoundariesIfNeeded();
-
-    debugStepInfo.valueSpreadCoeff = applyDiffusionIfEnabled(*flowValuesFboPtr,
-                                                            valueJacobiShader,
-                                                            valueDiffusionSourceFbo,
-                                                            valueSpreadParameter.get(),
-                                                            dt,
-                                                            valueDiffusionIterationsParameter.get(),
-                                                            1.0e-4f,
-                                                            1500.0f,
-                                                            obstaclesTex,
-                                                            useObstacles,
-                                                            obstacleThreshold,
-                                                            obstacleInvert);
-
-    // add forces
-    vorticityRenderer.render(flowVelocitiesFboPtr->getSource());
-
-    // Normalized 0..1 control mapped to the empirically useful range.
-    constexpr float VORTICITY_MAX = 0.3f;
-    const float vorticityStrength = std::clamp(getVorticityEffective(), 0.0f, 1.0f) * VORTICITY_MAX;
-    debugStepInfo.vorticityStrength = vorticityStrength;
-
-    applyVorticityForceShader.render(*flowVelocitiesFboPtr,
-                                     vorticityRenderer.getFbo(),
-                                     vorticityStrength,
-                                     dt,
-                                     obstaclesTex,
-                                     useObstacles,
-                                     obstacleThreshold,
-                                     obstacleInvert);
-    applyVelocityBoundariesIfNeeded();
-    applyVelocityCflClamp(dt);
-
-    if (buoyancyStrengthParameter.get() > 0.0f) {
-      if (buoyancyUseTemperatureParameter.get()) {
-        applyTemperatureBuoyancyShader.render(*flowVelocitiesFboPtr,
-                                              temperaturesFbo,
-                                              dt,
-                                              buoyancyStrengthParameter.get(),
-                                              ambientTemperatureParameter.get(),
-                                              temperatureBuoyancyThresholdParameter.get(),
-                                              gravityForceXParameter.get(),
-                                              gravityForceYParameter.get(),
-                                              obstaclesTex,
-                                              useObstacles,
-                                              obstacleThreshold,
-                                              obstacleInvert);
-      } else {
-        applyBouyancyShader.render(*flowVelocitiesFboPtr,
-                                   *flowValuesFboPtr,
-                                   dt,
-                                   buoyancyStrengthParameter.get(),
-                                   buoyancyDensityScaleParameter.get(),
-                                   buoyancyThresholdParameter.get(),
-                                   gravityForceXParameter.get(),
-                                   gravityForceYParameter.get(),
-                                   obstaclesTex,
-                                   useObstacles,
-                                   obstacleThreshold,
-                                   obstacleInvert);
-      }
-
-      applyVelocityBoundariesIfNeeded();
-      applyVelocityCflClamp(dt);
-    }
- 
-    // compute
-    if (useObstacles) {
-      divergenceRenderer.renderWithObstacles(flowVelocitiesFboPtr->getSource(), obstaclesTex, obstacleThreshold, obstacleInvert);
+    // Fixed step: real time is consumed in whole steps of 1 / "Fixed Step Rate" seconds. Beyond
+    // "Max Steps Per Update" the backlog is dropped, so a stall doesn't snowball.
+    const float stepSeconds = getFixedStepSeconds();
+    if (std::isfinite(rawFrameDt) && rawFrameDt > 0.0f) fixedStepAccumulator += rawFrameDt;
+    int steps = static_cast<int>(fixedStepAccumulator / stepSeconds);
+    if (steps > fixedStepMaxStepsParameter.get()) {
+      steps = fixedStepMaxStepsParameter.get();
+      fixedStepAccumulator = 0.0f;
     } else {
-      divergenceRenderer.render(flowVelocitiesFboPtr->getSource());
+      fixedStepAccumulator -= steps * stepSeconds;
     }
-    clearPressureIfNeeded();
+    runFrame(rawFrameDt, stepSeconds, steps);
+  }
 
-    const float pressureAlpha = -(dx * dx);
-    pressureJacobiShader.render(pressuresFbo,
-                                divergenceRenderer.getFbo().getTexture(),
-                                dt,
-                                pressureAlpha,
-                                0.25,
-                                pressureDiffusionIterationsParameter.get(),
-                                obstaclesTex,
-                                useObstacles,
-                                obstacleThreshold,
-                                obstacleInvert);
+  // Runs a frame as update() does once it has settled the frame's timing: steps steps of
+  // frameDt seconds, with the lagged GPU measurements and DebugStepInfo. FluidEventReplay uses
+  // it to replay recorded frames exactly as they ran, whatever the host's clock.
+  void stepFrame(float frameDt, int steps) { runFrame(frameDt, frameDt, steps); }
 
-    subtractDivergenceShader.render(*flowVelocitiesFboPtr,
-                                    pressuresFbo.getSource(),
-                                    obstaclesTex,
-                                    useObstacles,
-                                    obstacleThreshold,
-                                    obstacleInvert);
-    applyVelocityBoundariesIfNeeded();
+  // Impulses are scaled by the dt of the step they precede, which update() reads from the
+  // clock. Until the next update(), this fixes it instead, so a run driven by stepMany() or
+  // stepFrame() doesn't depend on timing; stepMany() sets it too.
+  void setImpulseFrameDt(float frameDt) { impulseFrameDt = frameDt; }
+
+  // The frame dt update() steps by without "Fixed Step": the clock's, within sane limits.
+  static float clampFrameDt(float frameDt) {
+    // Startup frames sometimes report 0 dt; use a sane baseline so forces respond immediately.
+    constexpr float STARTUP_DT = 1.0f / 30.0f;
+    constexpr float MIN_DT = 1.0f / 240.0f;
+    constexpr float MAX_DT = 1.0f / 15.0f;
+    if (!std::isfinite(frameDt) || frameDt <= 0.0f) return STARTUP_DT;
+    return std::clamp(frameDt, MIN_DT, MAX_DT);
+  }
+
+  // Runs n steps of frameDt seconds each back-to-back, e.g. to pre-warm a scene at load time or
+  // for offline renders faster than real time. Parameters are read once, and the lagged GPU
+  // measurements (sleep, tiles, adaptive substeps, pressure residual) and DebugStepInfo are
+  // skipped, so the result depends only on the state, the parameters and frameDt.
+  void stepMany(int n, float frameDt) {
+    if (n <= 0) return;
+    impulseFrameDt = frameDt;
+    if (!prepareStep()) return;
+    disableTiling();
+
+    const StepContext context = makeStepContext(frameDt, false);
+    for (int i = 0; i < n; ++i) step(context);
   }
   
   void draw(float x, float y, float w, float h) {
@@ -489,11 +533,22 @@ public:
     if (obstaclesFboPtr && obstaclesFboPtr->getSource().isAllocated()) return obstaclesFboPtr->getSource().getTexture();
     return flowValuesFboPtr->getSource().getTexture();
   }
+  // Solid/neighbour bits per velocity cell (see ObstacleMaskRenderer), rebuilt when the
+  // obstacles are marked dirty. Falls back to the values texture when obstacles are off, as a dummy
+  // binding for the shaders' obstaclesEnabled == 0 path.
+  const ofTexture& getObstacleMaskTexture() const {
+    if (isUsingObstacles() && obstacleMaskRenderer.getFbo().isAllocated()) return obstacleMaskRenderer.getTexture();
+    return flowValuesFboPtr->getSource().getTexture();
+  }
    
   // NOTE: this is not used by the MarkSynth Fluid wrapper; it has dedicated Mods instead
    void applyImpulse(const FluidSimulation::Impulse& impulse) {
      if (!isValid()) return;
+     if (inputListener) inputListener->onImpulse(impulse);
+     wake();
+     GpuTimerPool::Scope timing(stageTimers, "impulses");
 
+     OFXRENDERER_GL_COUNT(fboBinds, 2);
      flowValuesFboPtr->getSource().begin();
 
     ofPushStyle();
@@ -502,15 +557,13 @@ public:
     ofPopStyle();
     flowValuesFboPtr->getSource().end();
 
-    const float rawFrameDt = static_cast<float>(ofGetLastFrameTime());
-    const float frameDt = clampFrameDt(rawFrameDt);
-    constexpr float BASE_FPS = 30.0f;
-    const float dt = getDtEffective() * frameDt * BASE_FPS;
-
-    const bool useObstacles = obstaclesEnabledParameter.get() && obstaclesFboPtr && obstaclesFboPtr->getSource().isAllocated();
-    const ofTexture& obstaclesTex = useObstacles ? obstaclesFboPtr->getSource().getTexture()
-                                                 : flowValuesFboPtr->getSource().getTexture();
+    const float dt = getImpulseDt();
+    const bool useObstacles = isUsingObstacles();
+    if (useObstacles) updateObstacleMaskIfDirty();
+    const ofTexture& obstacleMaskTex = getObstacleMaskTexture();
 
+    markWrittenTiles(AddRadialImpulseShader::getFootprint(impulse.position, impulse.radius, flowVelocitiesFboPtr->getSize()));
+    addRadialImpulseShader.setFootprintOnly(impulseFootprintParameter.get());
     addRadialImpulseShader.render(*flowVelocitiesFboPtr,
                                   impulse.position,
                                   impulse.radius,
@@ -518,10 +571,8 @@ public:
                                   impulse.radialVelocity,
                                   impulse.swirlVelocity,
                                   dt,
-                                  obstaclesTex,
-                                  useObstacles,
-                                  obstacleThresholdParameter.get(),
-                                  obstacleInvertParameter.get());
+                                  obstacleMaskTex,
+                                  useObstacles);
 //    ofFloatColor velocityValue { impulse.velocity.r, impulse.velocity.g, 0.0, 1.0 };
 //    softCircleShader.render(impulse.position, impulse.radius, velocityValue);
     
@@ -529,10 +580,155 @@ public:
 //    addImpulseSpotShader.render(temperaturesFbo, impulse.position, impulse.radius, temperatureValue);
   }
 
+  // Applies a batch of impulses at once: the dye stamps go out as one instanced draw and the
+  // velocity impulses are injected together (one pass per AddRadialImpulsesShader::MAX_IMPULSES),
+  // so the per-frame cost no longer grows with the number of impulses.
+  void applyImpulses(std::span<const FluidSimulation::Impulse> impulses) {
+    if (!isValid()) return;
+    if (impulses.empty()) return;
+    if (inputListener) inputListener->onImpulses(impulses);
+    wake();
+    GpuTimerPool::Scope timing(stageTimers, "impulses");
+
+    dyeStampBatch.clear();
+    dyeStampBatch.reserve(impulses.size());
+    for (const auto& impulse : impulses) {
+      dyeStampBatch.push_back({ impulse.position, glm::vec2(impulse.radius * 2.0f), 0.0f, impulse.color * impulse.colorDensity });
+    }
+
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
+    flowValuesFboPtr->getSource().begin();
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_ADD);
+    softCircleShader.renderBatch(dyeStampBatch);
+    ofPopStyle();
+    flowValuesFboPtr->getSource().end();
+
+    radialImpulseBatch.clear();
+    radialImpulseBatch.reserve(impulses.size());
+    for (const auto& impulse : impulses) {
+      markWrittenTiles(AddRadialImpulseShader::getFootprint(impulse.position, impulse.radius, flowVelocitiesFboPtr->getSize()));
+      radialImpulseBatch.push_back({ impulse.position,
+                                     impulse.radius,
+                                     impulse.velocity,
+                                     impulse.radialVelocity,
+                                     impulse.swirlVelocity });
+    }
+
+    if (isUsingObstacles()) updateObstacleMaskIfDirty();
+    addRadialImpulsesShader.setFootprintOnly(impulseFootprintParameter.get());
+    addRadialImpulsesShader.render(*flowVelocitiesFboPtr,
+                                   radialImpulseBatch,
+                                   getImpulseDt(),
+                                   getObstacleMaskTexture(),
+                                   isUsingObstacles());
+  }
+
+  // Writes values, velocities, pressure (the solver's warm start), temperature and obstacles to
+  // path, with the CPU-side stepping state ("Fixed Step" accumulator, sleep state). With
+  // halfFloat the file is half the size but lossy. Float files restore exactly, so a restored
+  // simulation continues bit for bit as the saved one would have, as long as no mode driven by
+  // the asynchronous GPU measurements is on ("Sleep Enabled", "Tiled", "CFL Mode" Substep,
+  // "Pressure Adaptive"). Those restart from a fresh measurement after a load, a few steps later
+  // than the saved run would have had one, so they diverge slightly.
+  bool saveState(const std::string& path, bool halfFloat = false) {
+    if (!isValid()) return false;
+
+    const auto precision = halfFloat ? FluidStateFile::Precision::Float16 : FluidStateFile::Precision::Float32;
+    FluidStateFile::Writer writer;
+    const SteppingState stepping { fixedStepAccumulator, quietSteps, asleep ? 1u : 0u };
+    writer.setState(&stepping, sizeof(stepping));
+    writer.add(STATE_VALUES, flowValuesFboPtr->getSource().getTexture(), 4, precision);
+    writer.add(STATE_VELOCITIES, flowVelocitiesFboPtr->getSource().getTexture(), 2, precision);
+    writer.add(STATE_PRESSURE, pressuresFbo.getSource().getTexture(), 1, precision);
+    if (temperaturesFbo.isAllocated()) {
+      writer.add(STATE_TEMPERATURE, temperaturesFbo.getSource().getTexture(), 1, precision);
+    }
+    if (obstaclesFboPtr && obstaclesFboPtr->getSource().isAllocated()) {
+      writer.add(STATE_OBSTACLES, obstaclesFboPtr->getSource().getTexture(), 4, precision);
+    }
+
+    if (!writer.write(path)) {
+      ofLogError("FluidSimulation") << "saveState can't write " << path;
+      return false;
+    }
+    return true;
+  }
+
+  // Restores a saveState() file into the current buffers, which must have the saved sizes.
+  // Fields missing from the file (e.g. no obstacles were set up when saving) are left as they are.
+  bool loadState(const std::string& path) {
+    if (!isValid()) return false;
+
+    FluidStateFile::Reader reader;
+    if (!reader.open(path)) {
+      ofLogError("FluidSimulation") << "loadState: " << reader.getError();
+      return false;
+    }
+
+    struct Target {
+      StateField id;
+      PingPongFbo* fbo;
+    };
+    const Target targets[] = {
+      { STATE_VALUES, flowValuesFboPtr.get() },
+      { STATE_VELOCITIES, flowVelocitiesFboPtr.get() },
+      { STATE_PRESSURE, &pressuresFbo },
+      { STATE_TEMPERATURE, &temperaturesFbo },
+      { STATE_OBSTACLES, obstaclesFboPtr.get() },
+    };
+
+    // Check everything before touching any buffer.
+    if (!reader.find(STATE_VALUES) || !reader.find(STATE_VELOCITIES)) {
+      ofLogError("FluidSimulation") << "loadState: " << path << " has no values or velocities";
+      return false;
+    }
+    for (const auto& target : targets) {
+      const auto* field = reader.find(target.id);
+      if (!field) continue;
+      if (!target.fbo || !target.fbo->getSource().isAllocated()
+          || field->header.width != static_cast<uint32_t>(target.fbo->getWidth())
+          || field->header.height != static_cast<uint32_t>(target.fbo->getHeight())) {
+        ofLogError("FluidSimulation") << "loadState: field " << target.id << " in " << path
+                                      << " doesn't match the simulation's buffers";
+        return false;
+      }
+    }
+
+    // Both halves, so pixels a tiled pass leaves untouched agree too.
+    for (const auto& target : targets) {
+      const auto* field = reader.find(target.id);
+      if (!field) continue;
+      FluidStateFile::Reader::upload(*field, target.fbo->getSource().getTexture());
+      FluidStateFile::Reader::upload(*field, target.fbo->getTarget().getTexture());
+    }
+
+    pressureNeedsClear = false;
+    if (reader.find(STATE_OBSTACLES)) markObstaclesDirty();
+
+    // Readbacks still in flight measured the replaced fields: they are dropped, and the load
+    // counts as a write, so the measurement-driven modes wait for a measurement of the new state.
+    stateLoadStep = stepIndex + 1;
+    lastWakeStep = stateLoadStep;
+    resetTileActivity();
+
+    SteppingState stepping { 0.0f, 0, 0 }; // version 1 files: awake, nothing accumulated
+    const auto state = reader.getState();
+    if (state.size() == sizeof(stepping)) std::memcpy(&stepping, state.data(), sizeof(stepping));
+    fixedStepAccumulator = stepping.fixedStepAccumulator;
+    quietSteps = stepping.quietSteps;
+    asleep = stepping.asleep != 0;
+    return true;
+  }
+
   void applyTemperatureImpulse(const glm::vec2& positionPx, float radiusPx, float temperatureDelta) {
     if (!isValid()) return;
     if (temperatureDelta == 0.0f) return;
+    if (inputListener) inputListener->onTemperatureImpulse(positionPx, radiusPx, temperatureDelta);
+    wake();
+    GpuTimerPool::Scope timing(stageTimers, "impulses");
 
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     temperaturesFbo.getSource().begin();
 
     ofPushStyle();
@@ -547,6 +743,654 @@ public:
   }
   
  private:
+  // Field ids in saveState() files.
+  enum StateField : uint32_t {
+    STATE_VALUES = 1,
+    STATE_VELOCITIES = 2,
+    STATE_PRESSURE = 3,
+    STATE_TEMPERATURE = 4,
+    STATE_OBSTACLES = 5,
+  };
+
+  // The state block of saveState() files.
+  struct SteppingState {
+    float fixedStepAccumulator;
+    int32_t quietSteps;
+    uint32_t asleep;
+  };
+
+  // Everything a step reads, resolved once per update() or stepMany().
+  struct StepContext {
+    // Run the asynchronous measurements and record DebugStepInfo.
+    bool bookkeeping = true;
+    float frameDt = 0.0f;
+    float dt = 0.0f;
+    float dx = 0.0f;
+    float velocityDissipation = 1.0f;
+    float valueDissipation = 1.0f;
+    float temperatureDissipation = 1.0f;
+    float valueMax = 0.0f;
+    float vorticityStrength = 0.0f;
+    bool fused = false;
+    bool walls = false;
+    bool wrap = false; // "Boundary Mode" 1
+    bool temperatureEnabled = false;
+    float velocitySpread = 0.0f;
+    float valueSpread = 0.0f;
+    float temperatureSpread = 0.0f;
+    int velocityDiffusionIterations = 0;
+    int valueDiffusionIterations = 0;
+    int temperatureDiffusionIterations = 0;
+    bool diffusionSor = false;
+    float diffusionSorOmega = 1.0f;
+    FusedForcesShader::Buoyancy buoyancy; // mode BUOYANCY_NONE when off
+    bool cflSubstep = false;
+    int maxSubsteps = 1;
+    float maxStepCells = 0.0f; // the furthest the fields move in one step, in cells
+    float cflMaxDisp = 0.0f;   // the same in UV units
+    bool sleepEnabled = false; // and not kept awake by buoyancy
+    float sleepEpsilon = 0.0f;
+    int sleepDelay = 1;
+    bool tiled = false;        // and no buoyancy or temperature
+    float tileVelocityEpsilon = 0.0f;
+    float tileValueEpsilon = 0.0f;
+    int pressureSolver = PRESSURE_SOLVER_JACOBI;
+    int pressureIterations = 0;
+    int pressureVCycles = 0;
+    float pressureSorOmega = 1.0f;
+    bool pressureAdaptive = false;
+    float pressureTolerance = 0.0f;
+    int pressureCheckInterval = 1;
+    bool pressureResidual = false;
+    bool useObstacles = false;
+    const ofTexture* obstacleMask = nullptr;
+  };
+
+  // Handles parameter changes that need buffers revalidated and refreshes the obstacle mask.
+  // Returns false when the simulation can't step.
+  bool prepareStep() {
+    if (!isSetup()) return false;
+
+    const int boundaryMode = boundaryModeParameter.get();
+    if (boundaryMode != lastBoundaryMode) {
+      lastBoundaryMode = boundaryMode;
+      resetPressure();
+      validateExternalBuffers();
+      // The mask's edge neighbours depend on the wrap mode.
+      markObstaclesDirty();
+    }
+
+    const bool obstaclesEnabled = obstaclesEnabledParameter.get();
+    if (obstaclesEnabled != lastObstaclesEnabled) {
+      lastObstaclesEnabled = obstaclesEnabled;
+      resetPressure();
+      // Only the obstacles buffer's validity depends on this toggle.
+      if (!valid) {
+        validateExternalBuffers();
+      } else if (obstaclesEnabled && !validateObstaclesBuffer()) {
+        valid = false;
+        validationLogged = false;
+        logValidationErrorOnce();
+      }
+      markObstaclesDirty();
+    }
+
+    if (!isValid()) return false;
+
+    // The convergence test is JacobiShader's, so the other pressure solvers run their fixed count
+    const bool pressureAdaptiveIgnored = pressureAdaptiveParameter.get() && pressureSolverParameter.get() != PRESSURE_SOLVER_JACOBI;
+    if (pressureAdaptiveIgnored && !pressureAdaptiveIgnoredLogged) {
+      ofLogWarning("FluidSimulation") << "Pressure Adaptive only applies to the Jacobi pressure solver; ignoring it";
+    }
+    pressureAdaptiveIgnoredLogged = pressureAdaptiveIgnored;
+
+    if (!obstacleDirtyTrackingParameter.get()) markObstaclesDirty();
+    debugStepInfo.obstacleMaskRebuilt = isUsingObstacles() && updateObstacleMaskIfDirty();
+    return true;
+  }
+
+  // The stepping part of update() and stepFrame().
+  void runFrame(float rawFrameDt, float frameDt, int steps) {
+    if (inputListener) inputListener->onUpdate(rawFrameDt, frameDt, steps);
+    stageTimers.setEnabled(stageTimingParameter.get());
+    stageTimers.beginFrame();
+    if (!prepareStep()) return;
+
+    debugStepInfo.rawFrameDt = rawFrameDt;
+    debugStepInfo.fixedSteps = steps;
+    if (steps <= 0) return;
+
+    const StepContext context = makeStepContext(frameDt, true);
+    for (int i = 0; i < steps; ++i) step(context);
+  }
+
+  StepContext makeStepContext(float frameDt, bool bookkeeping) const {
+    StepContext context;
+    context.bookkeeping = bookkeeping;
+    context.frameDt = frameDt;
+
+    // dtParameter is tuned relative to a baseline framerate (historically 30fps).
+    // At 30fps, dtEffective ~= dtParameter.
+    // Effective dt used by the solver is: dt = dtParameter * frameDt * BASE_FPS.
+    static constexpr float BASE_FPS = 30.0f;
+    context.dt = getDtEffective() * frameDt * BASE_FPS;
+
+    const float gridSize = std::min(flowVelocitiesFboPtr->getWidth(), flowVelocitiesFboPtr->getHeight());
+    context.dx = 1.0f / std::max(1.0f, gridSize);
+
+    context.velocityDissipation = persistenceToDissipation(getVelocityAdvectDissipationEffective(), frameDt, 0.05f, 6.0f);
+    context.valueDissipation = persistenceToDissipation(getValueAdvectDissipationEffective(), frameDt, 0.2f, 30.0f);
+    context.temperatureDissipation = persistenceToDissipation(temperatureAdvectDissipationParameter.get(), frameDt, 0.2f, 30.0f);
+    context.valueMax = valueMaxParameter.get();
+
+    // Normalized 0..1 control mapped to the empirically useful range.
+    constexpr float VORTICITY_MAX = 0.3f;
+    context.vorticityStrength = std::clamp(getVorticityEffective(), 0.0f, 1.0f) * VORTICITY_MAX;
+
+    context.fused = fusedPassesParameter.get();
+    context.walls = boundaryModeParameter.get() == 0;
+    context.wrap = boundaryModeParameter.get() == 1;
+    context.temperatureEnabled = temperatureEnabledParameter.get();
+    context.velocitySpread = velocitySpreadParameter.get();
+    context.valueSpread = valueSpreadParameter.get();
+    context.temperatureSpread = temperatureSpreadParameter.get();
+    context.velocityDiffusionIterations = velocityDiffusionIterationsParameter.get();
+    context.valueDiffusionIterations = valueDiffusionIterationsParameter.get();
+    context.temperatureDiffusionIterations = temperatureDiffusionIterationsParameter.get();
+    context.diffusionSor = diffusionSolverParameter.get() == DIFFUSION_SOLVER_RED_BLACK_SOR;
+    context.diffusionSorOmega = diffusionSorOmegaParameter.get();
+
+    const float buoyancyStrength = buoyancyStrengthParameter.get();
+    const bool buoyancyUseTemperature = buoyancyUseTemperatureParameter.get();
+    context.buoyancy.mode = (buoyancyStrength <= 0.0f) ? FusedForcesShader::BUOYANCY_NONE
+        : buoyancyUseTemperature ? FusedForcesShader::BUOYANCY_TEMPERATURE
+        : FusedForcesShader::BUOYANCY_DENSITY;
+    context.buoyancy.strength = std::max(0.0f, buoyancyStrength);
+    context.buoyancy.densityScale = buoyancyDensityScaleParameter.get();
+    context.buoyancy.densityThreshold = buoyancyThresholdParameter.get();
+    context.buoyancy.ambientTemperature = ambientTemperatureParameter.get();
+    context.buoyancy.temperatureThreshold = temperatureBuoyancyThresholdParameter.get();
+    context.buoyancy.gravityForce = { gravityForceXParameter.get(), gravityForceYParameter.get() };
+
+    // Allow at most CFL_CELLS cells displacement per advection (sub)step, i.e. per step when
+    // clamping and per step across all "Max Substeps" when substepping.
+    context.cflSubstep = cflModeParameter.get() == CFL_MODE_SUBSTEP;
+    context.maxSubsteps = maxSubstepsParameter.get();
+    context.maxStepCells = CFL_CELLS * (context.cflSubstep ? context.maxSubsteps : 1);
+    context.cflMaxDisp = context.maxStepCells * context.dx;
+
+    // Buoyancy can set resting dye in motion, so the field is never considered at rest.
+    context.sleepEnabled = sleepEnabledParameter.get() && buoyancyStrength <= 0.0f;
+    context.sleepEpsilon = sleepEpsilonParameter.get();
+    context.sleepDelay = sleepDelayParameter.get();
+    // Buoyancy and temperature can act anywhere, so they turn tiling off.
+    context.tiled = tiledParameter.get() && buoyancyStrength <= 0.0f && !context.temperatureEnabled;
+    context.tileVelocityEpsilon = tileVelocityEpsilonParameter.get();
+    context.tileValueEpsilon = tileValueEpsilonParameter.get();
+
+    context.pressureSolver = pressureSolverParameter.get();
+    context.pressureIterations = pressureDiffusionIterationsParameter.get();
+    context.pressureVCycles = pressureVCyclesParameter.get();
+    context.pressureSorOmega = pressureSorOmegaParameter.get();
+    context.pressureAdaptive = pressureAdaptiveParameter.get() && context.pressureSolver == PRESSURE_SOLVER_JACOBI;
+    context.pressureTolerance = pressureToleranceParameter.get();
+    context.pressureCheckInterval = pressureCheckIntervalParameter.get();
+    context.pressureResidual = pressureResidualParameter.get();
+    context.useObstacles = isUsingObstacles();
+    context.obstacleMask = &getObstacleMaskTexture();
+    return context;
+  }
+
+  float getFixedStepSeconds() const {
+    return 1.0f / std::max(1.0f, fixedStepRateParameter.get());
+  }
+
+  void step(const StepContext& context) {
+    const float frameDt = context.frameDt;
+    const float dt = context.dt;
+    const float dx = context.dx;
+    const bool fused = context.fused;
+    const bool useObstacles = context.useObstacles;
+    const ofTexture& obstacleMaskTex = *context.obstacleMask;
+    // Without bookkeeping nothing is recorded.
+    DebugStepInfo unrecorded;
+    DebugStepInfo& info = context.bookkeeping ? debugStepInfo : unrecorded;
+
+    info.frameDt = frameDt;
+    info.dtEffective = dt;
+    info.dx = dx;
+    info.velocityDissipation = context.velocityDissipation;
+    info.valueDissipation = context.valueDissipation;
+
+    if (context.bookkeeping) {
+      const bool velocityMeasured = velocityReduction.update();
+      updateSleepState(context, velocityMeasured);
+      info.asleep = asleep;
+      if (asleep) {
+        // Velocities were zeroed on falling asleep, so advection only dissipates the values.
+        if (context.valueDissipation < 1.0f) {
+          GpuTimerPool::Scope timing(stageTimers, "advectValues");
+          valueAdvectShader.render(*flowValuesFboPtr,
+                                    flowVelocitiesFboPtr->getSource().getTexture(),
+                                    dt,
+                                    context.valueDissipation,
+                                    context.valueMax,
+                                    obstacleMaskTex,
+                                    useObstacles);
+        }
+        return;
+      }
+      updateTileCoverage(context);
+    } else {
+      ++stepIndex;
+    }
+
+    updateAdvectionSubsteps(context);
+    const int substeps = advectionSubsteps;
+    const float substepDt = dt / substeps;
+    info.advectionSubsteps = substeps;
+    info.cflClampApplied = cflClampRequired;
+
+    // Fused mode folds wall boundaries into advect/subtract and the force stage into one pass.
+    velocityAdvectShader.setFusedWallBoundary(fused && context.walls);
+    subtractDivergenceShader.setFusedWallBoundary(fused && context.walls);
+
+    // advect (per-substep dissipation compounds to the per-step value)
+    const float velocitySubstepDissipation = std::pow(context.velocityDissipation, 1.0f / substeps);
+    const float valueSubstepDissipation = std::pow(context.valueDissipation, 1.0f / substeps);
+    for (int substep = 0; substep < substeps; ++substep) {
+      {
+        GpuTimerPool::Scope timing(stageTimers, "advectVelocity");
+        velocityAdvectShader.render(*flowVelocitiesFboPtr,
+                                    flowVelocitiesFboPtr->getSource().getTexture(),
+                                    substepDt,
+                                    velocitySubstepDissipation,
+                                    0.0f,
+                                    obstacleMaskTex,
+                                    useObstacles);
+      }
+      if (!fused) applyVelocityBoundariesIfNeeded(context);
+
+      GpuTimerPool::Scope timing(stageTimers, "advectValues");
+      valueAdvectShader.render(*flowValuesFboPtr,
+                                flowVelocitiesFboPtr->getSource().getTexture(),
+                                substepDt,
+                                valueSubstepDissipation,
+                                context.valueMax,
+                                obstacleMaskTex,
+                                useObstacles);
+    }
+
+    if (context.temperatureEnabled) {
+      info.temperatureDissipation = context.temperatureDissipation;
+
+      const float temperatureSubstepDissipation = std::pow(context.temperatureDissipation, 1.0f / substeps);
+      for (int substep = 0; substep < substeps; ++substep) {
+        GpuTimerPool::Scope timing(stageTimers, "advectTemperature");
+        temperatureAdvectShader.render(temperaturesFbo,
+                                      flowVelocitiesFboPtr->getSource().getTexture(),
+                                      substepDt,
+                                      temperatureSubstepDissipation,
+                                      0.0f,
+                                      obstacleMaskTex,
+                                      useObstacles);
+      }
+
+      GpuTimerPool::Scope timing(stageTimers, "diffuseTemperature");
+      info.temperatureSpreadCoeff = applyDiffusionIfEnabled(temperaturesFbo,
+                                                            temperatureJacobiShader,
+                                                            context.diffusionSor ? &diffusionSorShader : nullptr,
+                                                            context.diffusionSorOmega,
+                                                            temperatureDiffusionSourceFbo,
+                                                            context.temperatureSpread,
+                                                            dt,
+                                                            context.temperatureDiffusionIterations,
+                                                            1.0e-4f,
+                                                            1500.0f,
+                                                            obstacleMaskTex,
+                                                            useObstacles);
+    }
+
+    // diffuse (resolution-independent in cell units)
+    stageTimers.begin("diffuseVelocity");
+    info.velocitySpreadCoeff = applyDiffusionIfEnabled(*flowVelocitiesFboPtr,
+                                                       velocityJacobiShader,
+                                                       context.diffusionSor ? &diffusionSorShader : nullptr,
+                                                       context.diffusionSorOmega,
+                                                       velocityDiffusionSourceFbo,
+                                                       context.velocitySpread,
+                                                       dt,
+                                                       context.velocityDiffusionIterations,
+                                                       1.0e-4f,
+                                                       80.0f,
+                                                       obstacleMaskTex,
+                                                       useObstacles);
+    stageTimers.end();
+    // Fused: advection already applied the walls, so this is only needed if diffusion ran.
+    if (!fused || info.velocitySpreadCoeff > 0.0f) applyVelocityBoundariesIfNeeded(context);
+
+    stageTimers.begin("diffuseValues");
+    info.valueSpreadCoeff = applyDiffusionIfEnabled(*flowValuesFboPtr,
+                                                    valueJacobiShader,
+                                                    context.diffusionSor ? &diffusionSorShader : nullptr,
+                                                    context.diffusionSorOmega,
+                                                    valueDiffusionSourceFbo,
+                                                    context.valueSpread,
+                                                    dt,
+                                                    context.valueDiffusionIterations,
+                                                    1.0e-4f,
+                                                    1500.0f,
+                                                    obstacleMaskTex,
+                                                    useObstacles);
+    stageTimers.end();
+
+    // add forces
+    info.vorticityStrength = context.vorticityStrength;
+    if (fused) {
+      applyFusedForces(context);
+    } else {
+      applyForces(context);
+    }
+
+    // compute
+    stageTimers.begin("divergence");
+    if (useObstacles) {
+      divergenceRenderer.renderWithObstacles(flowVelocitiesFboPtr->getSource(), obstacleMaskTex);
+    } else {
+      divergenceRenderer.render(flowVelocitiesFboPtr->getSource());
+    }
+    stageTimers.end();
+    clearPressureIfNeeded();
+
+    stageTimers.begin("pressure");
+    if (context.pressureSolver == PRESSURE_SOLVER_MULTIGRID) {
+      pressureMultigridSolver.solve(pressuresFbo,
+                                    divergenceRenderer.getFbo().getTexture(),
+                                    dx,
+                                    context.pressureVCycles,
+                                    obstacleMaskTex,
+                                    useObstacles);
+      info.pressureIterations = context.pressureVCycles
+          * (PoissonMultigridSolver::PRE_SMOOTH_ITERATIONS + PoissonMultigridSolver::POST_SMOOTH_ITERATIONS);
+    } else if (context.pressureSolver == PRESSURE_SOLVER_RED_BLACK_SOR) {
+      const float pressureAlpha = -(dx * dx);
+      pressureSorShader.render(pressuresFbo,
+                               divergenceRenderer.getFbo().getTexture(),
+                               dt,
+                               pressureAlpha,
+                               0.25,
+                               context.pressureIterations,
+                               context.pressureSorOmega,
+                               obstacleMaskTex,
+                               useObstacles);
+      info.pressureIterations = context.pressureIterations;
+    } else if (context.pressureAdaptive) {
+      const float pressureAlpha = -(dx * dx);
+      pressureJacobiShader.renderAdaptive(pressuresFbo,
+                                          divergenceRenderer.getFbo().getTexture(),
+                                          dt,
+                                          pressureAlpha,
+                                          0.25,
+                                          context.pressureIterations,
+                                          context.pressureTolerance,
+                                          context.pressureCheckInterval,
+                                          obstacleMaskTex,
+                                          useObstacles);
+      info.pressureIterations = pressureJacobiShader.getLastAdaptiveIterations();
+    } else {
+      const float pressureAlpha = -(dx * dx);
+      pressureJacobiShader.render(pressuresFbo,
+                                  divergenceRenderer.getFbo().getTexture(),
+                                  dt,
+                                  pressureAlpha,
+                                  0.25,
+                                  context.pressureIterations,
+                                  obstacleMaskTex,
+                                  useObstacles);
+      info.pressureIterations = context.pressureIterations;
+    }
+    stageTimers.end();
+    if (context.bookkeeping) measurePressureResidualIfEnabled(context);
+
+    stageTimers.begin("subtract");
+    subtractDivergenceShader.render(*flowVelocitiesFboPtr,
+                                    pressuresFbo.getSource(),
+                                    obstacleMaskTex,
+                                    useObstacles);
+    stageTimers.end();
+    if (!fused) applyVelocityBoundariesIfNeeded(context);
+
+    if (!context.bookkeeping) return;
+    if (context.sleepEnabled || context.cflSubstep) {
+      velocityReduction.reduce(flowVelocitiesFboPtr->getSource().getTexture(), FieldReduction::Input::Vector, stepIndex);
+    }
+    queueTileActivity(context);
+  }
+
+  // Impulses are applied between updates, so they use the same dt the next step will see.
+  float getImpulseDt() const {
+    float frameDt = clampFrameDt(static_cast<float>(ofGetLastFrameTime()));
+    if (fixedStepParameter.get()) frameDt = getFixedStepSeconds();
+    if (impulseFrameDt) frameDt = *impulseFrameDt;
+    constexpr float BASE_FPS = 30.0f;
+    return getDtEffective() * frameDt * BASE_FPS;
+  }
+
+  bool isUsingObstacles() const {
+    return obstaclesEnabledParameter.get() && obstaclesFboPtr && obstaclesFboPtr->getSource().isAllocated();
+  }
+
+  // Advances the step counter and decides whether this step sleeps, from the latest velocity
+  // reduction that was taken after the most recent wake().
+  void updateSleepState(const StepContext& context, bool velocityMeasured) {
+    ++stepIndex;
+    if (!context.sleepEnabled) {
+      if (asleep) wake();
+      return;
+    }
+    if (asleep) return;
+    if (!velocityMeasured) return;
+
+    const auto& result = velocityReduction.getResult();
+    if (result.tag < lastWakeStep) return;
+    const float maxDisplacement = result.max * context.dt / context.dx;
+    debugStepInfo.sleepMaxDisplacement = maxDisplacement;
+    quietSteps = (maxDisplacement < context.sleepEpsilon) ? quietSteps + 1 : 0;
+    if (quietSteps < context.sleepDelay) return;
+
+    asleep = true;
+    flowVelocitiesFboPtr->clearFloat(0.0f, 0.0f, 0.0f, 0.0f);
+  }
+
+  void allocateTileActivity(glm::vec2 size) {
+    tilesX = TileCoverage::getTileCount(static_cast<int>(size.x), TILE_SIZE);
+    tilesY = TileCoverage::getTileCount(static_cast<int>(size.y), TILE_SIZE);
+    ofFboSettings settings = createFboSettings({ static_cast<float>(tilesX), static_cast<float>(tilesY) }, GL_R8);
+    settings.minFilter = GL_NEAREST;
+    settings.maxFilter = GL_NEAREST;
+    tileActivityFbo.allocate(settings);
+    tileActivityShader.load();
+    resetTileActivity();
+  }
+
+  // Until a measurement arrives every tile counts as active.
+  void resetTileActivity() {
+    const size_t count = static_cast<size_t>(tilesX) * tilesY;
+    measuredTiles.assign(count, 1);
+    measuredTilesTag = 0;
+    writtenTiles.assign(count, 0);
+    activeTiles.assign(count, 1);
+    previousActiveTiles.assign(count, 1);
+    clearedTiles.assign(count, 0);
+  }
+
+  void disableTiling() {
+    if (!tilingActive) return;
+    applyTileCoverage(nullptr);
+    resetTileActivity();
+    tilingActive = false;
+  }
+
+  // "Tiled": picks the tiles this step rasterizes from the latest activity readback plus tiles
+  // written since (impulses, markRegionActive()), dilated by how far the fields can have moved
+  // since the measurement. Tiles that go idle are zeroed so the untouched pixels of every
+  // ping-pong buffer agree, but only on a measurement taken after the last write: until then
+  // the active set only grows. Buoyancy and temperature turn tiling off (see StepContext::tiled).
+  void updateTileCoverage(const StepContext& context) {
+    debugStepInfo.totalTiles = tilesX * tilesY;
+    if (!context.tiled) {
+      disableTiling();
+      debugStepInfo.activeTiles = debugStepInfo.totalTiles;
+      return;
+    }
+
+    uint64_t tag = 0;
+    if (tileActivityReadback.fetch(tileActivityReadbackData, &tag) && tag >= stateLoadStep
+        && tileActivityReadbackData.size() == measuredTiles.size()) {
+      std::transform(tileActivityReadbackData.begin(), tileActivityReadbackData.end(), measuredTiles.begin(),
+                     [](uint8_t v) { return static_cast<uint8_t>(v != 0); });
+      measuredTilesTag = tag;
+      // Writes up to the measured step are part of the measurement now.
+      if (tag >= lastWakeStep) std::fill(writtenTiles.begin(), writtenTiles.end(), 0);
+    }
+
+    // Content reaches at most maxStepCells further per step, over the steps from the measured
+    // one to the end of this one (writes land between steps, so are no older).
+    const uint64_t steps = stepIndex > measuredTilesTag ? stepIndex - measuredTilesTag : 1;
+    const float reachCells = context.maxStepCells * static_cast<float>(steps);
+    const int radius = std::max(1, static_cast<int>(std::ceil(reachCells / TILE_SIZE)));
+    dilationSeeds.resize(measuredTiles.size());
+    for (size_t i = 0; i < measuredTiles.size(); ++i) dilationSeeds[i] = measuredTiles[i] | writtenTiles[i];
+    TileCoverage::dilate(tilesX, tilesY, dilationSeeds, radius, context.wrap, activeTiles, dilationScratch);
+
+    const bool measurementCurrent = measuredTilesTag >= lastWakeStep;
+    bool anyCleared = false;
+    for (size_t i = 0; i < activeTiles.size(); ++i) {
+      if (!measurementCurrent) activeTiles[i] |= previousActiveTiles[i];
+      clearedTiles[i] = previousActiveTiles[i] && !activeTiles[i];
+      anyCleared = anyCleared || clearedTiles[i];
+    }
+    if (anyCleared) clearTiles(clearedTiles);
+    previousActiveTiles = activeTiles;
+
+    tileCoverage.update(static_cast<int>(flowVelocitiesFboPtr->getWidth()),
+                        static_cast<int>(flowVelocitiesFboPtr->getHeight()),
+                        TILE_SIZE,
+                        activeTiles);
+    applyTileCoverage(&tileCoverage);
+    tilingActive = true;
+    debugStepInfo.activeTiles = tileCoverage.getActiveTileCount();
+  }
+
+  // Measures per-tile activity of the finished step for a later updateTileCoverage().
+  void queueTileActivity(const StepContext& context) {
+    if (!tilingActive) return;
+    const float velocityThreshold = context.tileVelocityEpsilon * context.dx / std::max(context.dt, 1.0e-6f);
+    tileActivityShader.render(tileActivityFbo,
+                              flowVelocitiesFboPtr->getSource().getTexture(),
+                              flowValuesFboPtr->getSource().getTexture(),
+                              TILE_SIZE,
+                              velocityThreshold,
+                              context.tileValueEpsilon);
+    tileActivityReadback.read(tileActivityFbo, 0, 0, tilesX, tilesY, GL_RED, GL_UNSIGNED_BYTE,
+                              static_cast<size_t>(tilesX) * tilesY, stepIndex);
+  }
+
+  // Writes land before the next activity measurement, so their tiles are activated directly.
+  void markWrittenTiles(const ofRectangle& rectPx) {
+    if (!tilingActive) return;
+    const auto size = flowVelocitiesFboPtr->getSize();
+    const glm::vec2 lo = glm::clamp(glm::floor(glm::vec2(rectPx.getMinX(), rectPx.getMinY())), glm::vec2(0.0f), size);
+    const glm::vec2 hi = glm::clamp(glm::ceil(glm::vec2(rectPx.getMaxX(), rectPx.getMaxY())), glm::vec2(0.0f), size);
+    if (hi.x <= lo.x || hi.y <= lo.y) return;
+    const int x0 = static_cast<int>(lo.x) / TILE_SIZE;
+    const int y0 = static_cast<int>(lo.y) / TILE_SIZE;
+    const int x1 = std::min(tilesX - 1, static_cast<int>(hi.x - 1.0f) / TILE_SIZE);
+    const int y1 = std::min(tilesY - 1, static_cast<int>(hi.y - 1.0f) / TILE_SIZE);
+    for (int y = y0; y <= y1; ++y) {
+      std::fill_n(writtenTiles.begin() + static_cast<size_t>(y) * tilesX + x0, x1 - x0 + 1, 1);
+    }
+  }
+
+  // Zeroes the masked tiles in every full-resolution buffer the tiled passes write.
+  void clearTiles(std::span<const uint8_t> mask) {
+    GLint previousFbo = 0;
+    GLint previousScissor[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_SCISSOR_BOX, previousScissor);
+    const GLboolean scissorWasEnabled = glIsEnabled(GL_SCISSOR_TEST);
+    glEnable(GL_SCISSOR_TEST);
+
+    const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const auto size = flowVelocitiesFboPtr->getSize();
+    for (ofFbo* fbo : std::initializer_list<ofFbo*> {
+           &flowVelocitiesFboPtr->getSource(), &flowVelocitiesFboPtr->getTarget(),
+           &flowValuesFboPtr->getSource(), &flowValuesFboPtr->getTarget(),
+           &pressuresFbo.getSource(), &pressuresFbo.getTarget(),
+           &divergenceRenderer.getFbo(), &vorticityRenderer.getFbo(),
+           &velocityDiffusionSourceFbo, &valueDiffusionSourceFbo }) {
+      if (!fbo->isAllocated() || fbo->getWidth() != size.x || fbo->getHeight() != size.y) continue;
+      OFXRENDERER_GL_COUNT(fboBinds, 1);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo->getId());
+      TileCoverage::forEachRun(tilesX, tilesY, mask, [&](int x0, int x1, int y) {
+        glScissor(x0 * TILE_SIZE, y * TILE_SIZE, (x1 - x0) * TILE_SIZE, TILE_SIZE);
+        OFXRENDERER_GL_COUNT(clears, 1);
+        glClearBufferfv(GL_COLOR, 0, zero);
+      });
+    }
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFbo);
+    glScissor(previousScissor[0], previousScissor[1], previousScissor[2], previousScissor[3]);
+    if (!scissorWasEnabled) glDisable(GL_SCISSOR_TEST);
+  }
+
+  // The passes that run over the velocity grid; the multigrid solver, residual and temperature
+  // passes always run full-field.
+  void applyTileCoverage(TileCoverage* coverage) {
+    for (Shader* shader : std::initializer_list<Shader*> {
+           &valueAdvectShader, &velocityAdvectShader,
+           &valueJacobiShader, &velocityJacobiShader, &pressureJacobiShader,
+           &pressureSorShader, &diffusionSorShader,
+           &divergenceRenderer, &subtractDivergenceShader, &vorticityRenderer, &applyVorticityForceShader,
+           &velocityBoundaryShader, &velocityCflClampShader, &fusedForcesShader }) {
+      shader->setTileCoverage(coverage);
+    }
+  }
+
+  // Rebuilds the obstacle mask if the obstacles changed since it was last built.
+  // Returns true when it was rebuilt.
+  bool updateObstacleMaskIfDirty() {
+    const float threshold = obstacleThresholdParameter.get();
+    const bool invert = obstacleInvertParameter.get();
+    if (obstacleMaskGeneration == obstaclesGeneration
+        && obstacleMaskThreshold == threshold
+        && obstacleMaskInvert == invert) {
+      return false;
+    }
+
+    obstacleMaskRenderer.render(obstaclesFboPtr->getSource().getTexture(), threshold, invert);
+    obstacleMaskGeneration = obstaclesGeneration;
+    obstacleMaskThreshold = threshold;
+    obstacleMaskInvert = invert;
+    return true;
+  }
+
+  void applyPassMode() {
+    for (Shader* shader : std::initializer_list<Shader*> {
+           &valueAdvectShader, &velocityAdvectShader, &temperatureAdvectShader,
+           &valueJacobiShader, &velocityJacobiShader, &temperatureJacobiShader, &pressureJacobiShader,
+           &pressureSorShader, &diffusionSorShader, &pressureResidualShader, &obstacleMaskRenderer,
+           &divergenceRenderer, &subtractDivergenceShader, &vorticityRenderer, &applyVorticityForceShader,
+           &velocityBoundaryShader, &velocityCflClampShader, &applyBouyancyShader, &applyTemperatureBuoyancyShader,
+           &fusedForcesShader }) {
+      shader->setPassMode(passMode);
+    }
+    pressureMultigridSolver.setPassMode(passMode);
+    pressureResidualReduction.setPassMode(passMode);
+    tileActivityShader.setPassMode(passMode);
+    velocityReduction.setPassMode(passMode);
+  }
+
   static const char* boundaryModeToString(int mode) {
     switch (mode) {
       case 0: return "SolidWalls";
@@ -586,6 +1430,9 @@ public:
     setFboWrap(pressuresFbo.getSource(), wrap);
     setFboWrap(pressuresFbo.getTarget(), wrap);
     setFboWrap(divergenceRenderer.getFbo(), wrap);
+    setFboWrap(pressureResidualFbo, wrap);
+    setFboWrap(obstacleMaskRenderer.getFbo(), wrap);
+    pressureMultigridSolver.setWrap(wrap);
     setFboWrap(vorticityRenderer.getFbo(), wrap);
     setFboWrap(velocityDiffusionSourceFbo, wrap);
     setFboWrap(valueDiffusionSourceFbo, wrap);
@@ -643,15 +1490,6 @@ public:
     ofPopStyle();
   }
 
-  static float clampFrameDt(float frameDt) {
-    // Startup frames sometimes report 0 dt; use a sane baseline so forces respond immediately.
-    constexpr float STARTUP_DT = 1.0f / 30.0f;
-    constexpr float MIN_DT = 1.0f / 240.0f;
-    constexpr float MAX_DT = 1.0f / 15.0f;
-    if (!std::isfinite(frameDt) || frameDt <= 0.0f) return STARTUP_DT;
-    return std::clamp(frameDt, MIN_DT, MAX_DT);
-  }
-
   static float persistenceToDissipation(float persistence, float frameDt, float minHalfLife, float maxHalfLife) {
     const float p = std::clamp(persistence, 0.0f, 1.0f);
     const float minHL = std::max(1.0e-3f, minHalfLife);
@@ -701,16 +1539,16 @@ public:
 
   static float applyDiffusionIfEnabled(PingPongFbo& field,
                                        JacobiShader& solver,
+                                       RedBlackSorShader* sorSolver,
+                                       float sorOmega,
                                        ofFbo& diffusionSource,
                                        float spread,
                                        float dt,
                                        int iterations,
                                        float minRateCells,
                                        float maxRateCells,
-                                       const ofTexture& obstaclesTex,
-                                       bool obstaclesEnabled,
-                                       float obstacleThreshold,
-                                       bool obstacleInvert) {
+                                       const ofTexture& obstacleMaskTex,
+                                       bool obstaclesEnabled) {
     if (iterations <= 0) return 0.0f;
 
     const float rateCells = spreadToDiffusionRateCells(spread, minRateCells, maxRateCells);
@@ -719,36 +1557,158 @@ public:
     if (!diffusionToJacobiParams(rateCells, dt, alpha, rBeta)) return 0.0f;
 
     copyToFbo(field.getSource(), diffusionSource);
+    if (sorSolver) {
+      sorSolver->render(field,
+                        diffusionSource.getTexture(),
+                        dt,
+                        alpha,
+                        rBeta,
+                        iterations,
+                        sorOmega,
+                        obstacleMaskTex,
+                        obstaclesEnabled);
+      return rateCells;
+    }
     solver.render(field,
                   diffusionSource.getTexture(),
                   dt,
                   alpha,
                   rBeta,
                   iterations,
-                  obstaclesTex,
-                  obstaclesEnabled,
-                  obstacleThreshold,
-                  obstacleInvert);
+                  obstacleMaskTex,
+                  obstaclesEnabled);
     return rateCells;
   }
 
-  void applyVelocityBoundariesIfNeeded() {
-    if (boundaryModeParameter.get() != 0) return; // SolidWalls only for now
+  void applyForces(const StepContext& context) {
+    const float dt = context.dt;
+    const ofTexture& obstacleMaskTex = *context.obstacleMask;
+    const bool useObstacles = context.useObstacles;
+    stageTimers.begin("vorticity");
+    vorticityRenderer.render(flowVelocitiesFboPtr->getSource());
+
+    applyVorticityForceShader.render(*flowVelocitiesFboPtr,
+                                     vorticityRenderer.getFbo(),
+                                     context.vorticityStrength,
+                                     dt,
+                                     obstacleMaskTex,
+                                     useObstacles);
+    stageTimers.end();
+    applyVelocityBoundariesIfNeeded(context);
+    applyVelocityCflClamp(context);
+
+    const FusedForcesShader::Buoyancy& buoyancy = context.buoyancy;
+    if (buoyancy.mode != FusedForcesShader::BUOYANCY_NONE) {
+      stageTimers.begin("buoyancy");
+      if (buoyancy.mode == FusedForcesShader::BUOYANCY_TEMPERATURE) {
+        applyTemperatureBuoyancyShader.render(*flowVelocitiesFboPtr,
+                                              temperaturesFbo,
+                                              dt,
+                                              buoyancy.strength,
+                                              buoyancy.ambientTemperature,
+                                              buoyancy.temperatureThreshold,
+                                              buoyancy.gravityForce.x,
+                                              buoyancy.gravityForce.y,
+                                              obstacleMaskTex,
+                                              useObstacles);
+      } else {
+        applyBouyancyShader.render(*flowVelocitiesFboPtr,
+                                   *flowValuesFboPtr,
+                                   dt,
+                                   buoyancy.strength,
+                                   buoyancy.densityScale,
+                                   buoyancy.densityThreshold,
+                                   buoyancy.gravityForce.x,
+                                   buoyancy.gravityForce.y,
+                                   obstacleMaskTex,
+                                   useObstacles);
+      }
+      stageTimers.end();
+
+      applyVelocityBoundariesIfNeeded(context);
+      applyVelocityCflClamp(context);
+    }
+  }
+
+  // Same result as applyForces() in one pass (see FusedForcesShader); the curl texture is not updated.
+  void applyFusedForces(const StepContext& context) {
+    const ofTexture& buoyancySource = (context.buoyancy.mode == FusedForcesShader::BUOYANCY_TEMPERATURE)
+        ? temperaturesFbo.getSource().getTexture()
+        : flowValuesFboPtr->getSource().getTexture();
+
+    GpuTimerPool::Scope timing(stageTimers, "fusedForces");
+    fusedForcesShader.render(*flowVelocitiesFboPtr,
+                             context.vorticityStrength,
+                             context.dt,
+                             context.cflMaxDisp,
+                             context.walls,
+                             context.wrap ? GL_REPEAT : GL_CLAMP_TO_EDGE, // getExpectedWrapMode()
+                             context.buoyancy,
+                             buoyancySource,
+                             *context.obstacleMask,
+                             context.useObstacles);
+  }
+
+  void applyVelocityBoundariesIfNeeded(const StepContext& context) {
+    if (!context.walls) return; // SolidWalls only for now
+    GpuTimerPool::Scope timing(stageTimers, "boundaries");
     velocityBoundaryShader.render(*flowVelocitiesFboPtr);
   }
 
-  void applyVelocityCflClamp(float dt) {
-    if (dt <= 0.0f) return;
+  // "CFL Mode" Substep: picks enough advection substeps that each moves at most CFL_CELLS,
+  // from the max |velocity| measured after an earlier step (velocityReduction). The clamp pass
+  // is only needed when "Max Substeps" would not be enough. Without a measurement taken since
+  // the last write into the velocities (impulses, wake(), loadState()) it takes "Max Substeps"
+  // and clamps, as the measurement says nothing about the new velocities. Without bookkeeping
+  // (stepMany) it always does that, so results don't depend on timing.
+  void updateAdvectionSubsteps(const StepContext& context) {
+    advectionSubsteps = 1;
+    cflClampRequired = true;
+    if (!context.cflSubstep) return;
+
+    const int maxSubsteps = context.maxSubsteps;
+    advectionSubsteps = maxSubsteps;
+    if (!context.bookkeeping || !velocityReduction.hasResult()) return;
+    const auto& result = velocityReduction.getResult();
+    if (result.tag < lastWakeStep) return;
+
+    const float maxCells = result.max * context.dt / context.dx;
+    const int neededSubsteps = std::max(1, static_cast<int>(std::ceil(maxCells / CFL_CELLS)));
+    advectionSubsteps = std::min(neededSubsteps, maxSubsteps);
+    cflClampRequired = neededSubsteps > maxSubsteps;
+  }
+
+  void applyVelocityCflClamp(const StepContext& context) {
+    if (context.dt <= 0.0f) return;
     if (!flowVelocitiesFboPtr) return;
+    if (!cflClampRequired) return;
 
-    const float gridSize = std::min(flowVelocitiesFboPtr->getWidth(), flowVelocitiesFboPtr->getHeight());
-    const float dx = 1.0f / std::max(1.0f, gridSize);
+    GpuTimerPool::Scope timing(stageTimers, "cflClamp");
+    velocityCflClampShader.render(*flowVelocitiesFboPtr, context.dt, context.cflMaxDisp);
+  }
 
-    // Allow at most N cells displacement per step.
-    constexpr float CFL_CELLS = 4.0f;
-    const float maxDisp = CFL_CELLS * dx;
+  void measurePressureResidualIfEnabled(const StepContext& context) {
+    if (!context.pressureResidual) {
+      debugStepInfo.pressureResidualValid = false;
+      return;
+    }
+
+    if (pressureResidualReduction.update()) {
+      const auto& result = pressureResidualReduction.getResult();
+      debugStepInfo.pressureResidualValid = true;
+      debugStepInfo.pressureResidualMax = result.max;
+      debugStepInfo.pressureResidualRms = result.rms;
+    }
 
-    velocityCflClampShader.render(*flowVelocitiesFboPtr, dt, maxDisp);
+    // Skip the residual pass too while every readback is still in flight.
+    if (!pressureResidualReduction.canReduce()) return;
+    pressureResidualShader.render(pressureResidualFbo,
+                                  pressuresFbo.getSource(),
+                                  divergenceRenderer.getFbo().getTexture(),
+                                  context.dx,
+                                  *context.obstacleMask,
+                                  context.useObstacles);
+    pressureResidualReduction.reduce(pressureResidualFbo.getTexture(), FieldReduction::Input::Scalar);
   }
 
   void clearPressureIfNeeded() {
@@ -757,6 +1717,8 @@ public:
     auto clearFbo = [](ofFbo& fbo) {
       if (!fbo.isAllocated()) return;
       fbo.begin();
+      OFXRENDERER_GL_COUNT_FOR(FluidSimulation, fboBinds, 2);
+      OFXRENDERER_GL_COUNT_FOR(FluidSimulation, clears, 1);
       fbo.clearColorBuffer(ofFloatColor(0.0f, 0.0f, 0.0f, 0.0f));
       fbo.end();
     };
@@ -786,71 +1748,71 @@ public:
       return false;
     }
 
-    const int boundaryMode = boundaryModeParameter.get();
-    const GLint expectedWrap = getExpectedWrapMode();
+    if (!validateTexture(flowValuesFboPtr->getSource().getTexture(), "values")) {
+      logValidationErrorOnce();
+      return false;
+    }
 
-    const auto validateTexture = [&](const ofTexture& tex, const char* label) -> bool {
-      const auto& data = tex.getTextureData();
+    if (!validateTexture(flowVelocitiesFboPtr->getSource().getTexture(), "velocities")) {
+      logValidationErrorOnce();
+      return false;
+    }
 
-      if (data.textureTarget != GL_TEXTURE_2D) {
-        validationError = std::string("FluidSimulation requires GL_TEXTURE_2D textures (got target=") + ofToString(data.textureTarget)
-                          + ") for " + label;
-        return false;
-      }
+    if (obstaclesEnabledParameter.get() && !validateObstaclesBuffer()) {
+      logValidationErrorOnce();
+      return false;
+    }
 
-      const float eps = 1e-4f;
-      if (std::abs(data.tex_u - 1.0f) > eps || std::abs(data.tex_t - 1.0f) > eps) {
-        validationError = std::string("FluidSimulation requires normalized texcoords (tex_u=1, tex_t=1); got tex_u=")
-                          + ofToString(data.tex_u, 4) + " tex_t=" + ofToString(data.tex_t, 4) + " for " + label;
-        return false;
-      }
+    valid = true;
+    return true;
+  }
 
-      if (data.wrapModeHorizontal != expectedWrap || data.wrapModeVertical != expectedWrap) {
-        validationError = std::string("FluidSimulation boundary mode ") + boundaryModeToString(boundaryMode) + " requires "
-                          + wrapModeToString(expectedWrap) + " wrap; got " + wrapModeToString(data.wrapModeHorizontal) + ","
-                          + wrapModeToString(data.wrapModeVertical) + " for " + label;
-        return false;
-      }
+  bool validateTexture(const ofTexture& tex, const char* label) {
+    const int boundaryMode = boundaryModeParameter.get();
+    const GLint expectedWrap = getExpectedWrapMode();
+    const auto& data = tex.getTextureData();
 
-      return true;
-    };
+    if (data.textureTarget != GL_TEXTURE_2D) {
+      validationError = std::string("FluidSimulation requires GL_TEXTURE_2D textures (got target=") + ofToString(data.textureTarget)
+                        + ") for " + label;
+      return false;
+    }
 
-    if (!validateTexture(flowValuesFboPtr->getSource().getTexture(), "values")) {
-      logValidationErrorOnce();
+    const float eps = 1e-4f;
+    if (std::abs(data.tex_u - 1.0f) > eps || std::abs(data.tex_t - 1.0f) > eps) {
+      validationError = std::string("FluidSimulation requires normalized texcoords (tex_u=1, tex_t=1); got tex_u=")
+                        + ofToString(data.tex_u, 4) + " tex_t=" + ofToString(data.tex_t, 4) + " for " + label;
       return false;
     }
 
-    if (!validateTexture(flowVelocitiesFboPtr->getSource().getTexture(), "velocities")) {
-      logValidationErrorOnce();
+    if (data.wrapModeHorizontal != expectedWrap || data.wrapModeVertical != expectedWrap) {
+      validationError = std::string("FluidSimulation boundary mode ") + boundaryModeToString(boundaryMode) + " requires "
+                        + wrapModeToString(expectedWrap) + " wrap; got " + wrapModeToString(data.wrapModeHorizontal) + ","
+                        + wrapModeToString(data.wrapModeVertical) + " for " + label;
       return false;
     }
 
-    if (obstaclesEnabledParameter.get()) {
-      if (!obstaclesFboPtr || !obstaclesFboPtr->getSource().isAllocated()) {
-        validationError = "FluidSimulation ObstaclesEnabled requires an allocated obstacles buffer";
-        logValidationErrorOnce();
-        return false;
-      }
+    return true;
+  }
 
-      const int w = static_cast<int>(flowVelocitiesFboPtr->getWidth());
-      const int h = static_cast<int>(flowVelocitiesFboPtr->getHeight());
-      const int ow = static_cast<int>(obstaclesFboPtr->getWidth());
-      const int oh = static_cast<int>(obstaclesFboPtr->getHeight());
-      if (ow != w || oh != h) {
-        validationError = std::string("FluidSimulation obstacles size must match velocities (expected " )
-                          + ofToString(w) + "x" + ofToString(h) + " got " + ofToString(ow) + "x" + ofToString(oh) + ")";
-        logValidationErrorOnce();
-        return false;
-      }
+  // Checks the obstacles buffer against the (already validated) velocities; sets validationError on failure.
+  bool validateObstaclesBuffer() {
+    if (!obstaclesFboPtr || !obstaclesFboPtr->getSource().isAllocated()) {
+      validationError = "FluidSimulation ObstaclesEnabled requires an allocated obstacles buffer";
+      return false;
+    }
 
-      if (!validateTexture(obstaclesFboPtr->getSource().getTexture(), "obstacles")) {
-        logValidationErrorOnce();
-        return false;
-      }
+    const int w = static_cast<int>(flowVelocitiesFboPtr->getWidth());
+    const int h = static_cast<int>(flowVelocitiesFboPtr->getHeight());
+    const int ow = static_cast<int>(obstaclesFboPtr->getWidth());
+    const int oh = static_cast<int>(obstaclesFboPtr->getHeight());
+    if (ow != w || oh != h) {
+      validationError = std::string("FluidSimulation obstacles size must match velocities (expected " )
+                        + ofToString(w) + "x" + ofToString(h) + " got " + ofToString(ow) + "x" + ofToString(oh) + ")";
+      return false;
     }
 
-    valid = true;
-    return true;
+    return validateTexture(obstaclesFboPtr->getSource().getTexture(), "obstacles");
   }
 
   void logValidationErrorOnce() {
@@ -886,6 +1848,36 @@ public:
   // Set to 0 to disable.
   ofParameter<float> valueMaxParameter { "Value Max", 1.0f, 0.0f, 10.0f };
 
+  // Rasterize velocity impulses only over their bounding rectangles rather than the whole field.
+  ofParameter<bool> impulseFootprintParameter { "Impulse Footprint", true };
+
+  // Fold wall boundaries into advect/subtract and run curl + confinement + buoyancy + CFL clamp as one
+  // pass (FusedForcesShader). Same results with fewer full-field passes; getCurlTexture() goes stale.
+  ofParameter<bool> fusedPassesParameter { "Fused Passes", false };
+
+  // Stop solving while the field is at rest (see wake()). Epsilon is in cells per step.
+  ofParameter<bool> sleepEnabledParameter { "Sleep Enabled", false };
+  ofParameter<float> sleepEpsilonParameter { "Sleep Epsilon", 0.01f, 0.0f, 0.5f };
+  ofParameter<int> sleepDelayParameter { "Sleep Delay", 30, 1, 600 };
+
+  // Run the velocity-grid passes only over TILE_SIZE tiles with motion or dye (see
+  // updateTileCoverage()). Epsilons are cells per step and value magnitude.
+  ofParameter<bool> tiledParameter { "Tiled", false };
+  ofParameter<float> tileVelocityEpsilonParameter { "Tile Velocity Epsilon", 0.01f, 0.0f, 0.5f };
+  ofParameter<float> tileValueEpsilonParameter { "Tile Value Epsilon", 0.002f, 0.0f, 0.1f };
+
+  // See CflMode and updateAdvectionSubsteps().
+  ofParameter<int> cflModeParameter { "CFL Mode", CFL_MODE_CLAMP, CFL_MODE_CLAMP, CFL_MODE_SUBSTEP };
+  ofParameter<int> maxSubstepsParameter { "Max Substeps", 4, 1, 8 };
+
+  // Step in fixed increments of simulated time rather than once per frame (see update()).
+  ofParameter<bool> fixedStepParameter { "Fixed Step", false };
+  ofParameter<float> fixedStepRateParameter { "Fixed Step Rate", 60.0f, 15.0f, 240.0f };
+  ofParameter<int> fixedStepMaxStepsParameter { "Max Steps Per Update", 4, 1, 16 };
+
+  // Times each solver stage on the GPU for getStageTimings() (two timestamp queries per pass).
+  ofParameter<bool> stageTimingParameter { "Stage Timing", false };
+
   ofParameterGroup temperatureParameters { "Temperature" };
   ofParameter<bool> temperatureEnabledParameter { "TempEnabled", false };
   ofParameter<float> temperatureAdvectDissipationParameter { "Temperature Dissipation", 0.9f, 0.0f, 1.0f };
@@ -896,10 +1888,30 @@ public:
   ofParameter<bool> obstaclesEnabledParameter { "ObstaclesEnabled", false };
   ofParameter<float> obstacleThresholdParameter { "Obstacle Threshold", 0.5f, 0.0f, 1.0f };
   ofParameter<bool> obstacleInvertParameter { "Obstacle Invert", false };
+  // When enabled, the obstacle mask is only rebuilt after markObstaclesDirty().
+  ofParameter<bool> obstacleDirtyTrackingParameter { "Obstacle Dirty Tracking", false };
 
   ofParameter<int> valueDiffusionIterationsParameter = JacobiShader::createIterationsParameter("Value ", 1);
   ofParameter<int> velocityDiffusionIterationsParameter = JacobiShader::createIterationsParameter("Velocity ", 1);
   ofParameter<int> pressureDiffusionIterationsParameter = JacobiShader::createIterationsParameter("Pressure ", 10);
+  // 0: Jacobi (Pressure Iterations full-res passes), 1: Multigrid (Pressure V-Cycles),
+  // 2: red-black SOR (Pressure Iterations iterations of two half-passes, each iteration about 7/6
+  // of a Jacobi pass in fetches plus a second write; it reaches Jacobi's residual for about
+  // 0.8-0.9x the fetches at Pressure SOR Omega 1.4, and breaks even near 1.6)
+  ofParameter<int> pressureSolverParameter { "Pressure Solver", PRESSURE_SOLVER_JACOBI, PRESSURE_SOLVER_JACOBI, PRESSURE_SOLVER_RED_BLACK_SOR };
+  ofParameter<float> pressureSorOmegaParameter = RedBlackSorShader::createOmegaParameter("Pressure ", 1.4f);
+  // Solver for value/velocity/temperature diffusion. 0: Jacobi, 1: red-black SOR
+  ofParameter<int> diffusionSolverParameter { "Diffusion Solver", DIFFUSION_SOLVER_JACOBI, DIFFUSION_SOLVER_JACOBI, DIFFUSION_SOLVER_RED_BLACK_SOR };
+  ofParameter<float> diffusionSorOmegaParameter = RedBlackSorShader::createOmegaParameter("Diffusion ", 1.2f);
+  ofParameter<int> pressureVCyclesParameter = PoissonMultigridSolver::createVCyclesParameter("Pressure ", 2);
+  // Jacobi only (ignored with a warning otherwise): stop iterating once every cell's residual is below
+  // Pressure Tolerance (divergence units), testing every Pressure Check Interval iterations. Pressure
+  // Iterations becomes the maximum.
+  ofParameter<bool> pressureAdaptiveParameter { "Pressure Adaptive", false };
+  ofParameter<float> pressureToleranceParameter { "Pressure Tolerance", 0.01f, 0.0f, 1.0f };
+  ofParameter<int> pressureCheckIntervalParameter { "Pressure Check Interval", 2, 2, 10 };
+  // Measures the post-solve residual into DebugStepInfo (costs a residual pass and a small reduction).
+  ofParameter<bool> pressureResidualParameter { "Pressure Residual", false };
   ofParameterGroup buoyancyParameters { "Buoyancy" };
   ofParameter<float> buoyancyStrengthParameter = ApplyBouyancyShader::createBuoyancyStrengthParameter();
   ofParameter<float> buoyancyDensityScaleParameter = ApplyBouyancyShader::createDensityScaleParameter();
@@ -918,8 +1930,43 @@ public:
   bool pressureNeedsClear = true;
 
   bool ownsFlowBuffers = false;
+  Shader::PassMode passMode = Shader::PassMode::Fbo;
   int lastBoundaryMode = 0;
+  bool pressureAdaptiveIgnoredLogged = false;
   bool lastObstaclesEnabled = false;
+  uint64_t obstaclesGeneration = 0;
+  // Inputs the obstacle mask was last built from.
+  uint64_t obstacleMaskGeneration = UINT64_MAX;
+  float obstacleMaskThreshold = 0.0f;
+  bool obstacleMaskInvert = false;
+  uint64_t stepIndex = 0;
+  uint64_t lastWakeStep = 0;
+  uint64_t stateLoadStep = 0; // measurements tagged before this predate the last loadState()
+  int quietSteps = 0;
+  bool asleep = false;
+
+  float fixedStepAccumulator = 0.0f;
+  // Set while the simulation is driven by stepMany(), whose dt the next impulses then use.
+  std::optional<float> impulseFrameDt; // see setImpulseFrameDt()
+  InputListener* inputListener = nullptr;
+
+  static constexpr float CFL_CELLS = 4.0f;
+  int advectionSubsteps = 1;
+  bool cflClampRequired = true;
+
+  static constexpr int TILE_SIZE = 32;
+  int tilesX = 0;
+  int tilesY = 0;
+  bool tilingActive = false;
+  // Row-major per-tile flags (1 = active), tile row 0 at texture row 0.
+  std::vector<uint8_t> measuredTiles;
+  uint64_t measuredTilesTag = 0; // the step measuredTiles was measured after
+  std::vector<uint8_t> writtenTiles; // impulses and markRegionActive() since the measurement
+  std::vector<uint8_t> activeTiles;
+  std::vector<uint8_t> previousActiveTiles;
+  std::vector<uint8_t> clearedTiles;
+  std::vector<uint8_t> dilationSeeds;
+  std::vector<uint8_t> dilationScratch;
 
   std::shared_ptr<PingPongFbo> flowValuesFboPtr;
   std::shared_ptr<PingPongFbo> flowVelocitiesFboPtr;
@@ -934,8 +1981,22 @@ public:
   JacobiShader velocityJacobiShader;
   JacobiShader temperatureJacobiShader;
   DivergenceRenderer divergenceRenderer;
+  ObstacleMaskRenderer obstacleMaskRenderer;
   PingPongFbo pressuresFbo;
   JacobiShader pressureJacobiShader;
+  RedBlackSorShader pressureSorShader;
+  RedBlackSorShader diffusionSorShader;
+  PoissonMultigridSolver pressureMultigridSolver;
+  PoissonResidualShader pressureResidualShader;
+  ofFbo pressureResidualFbo;
+  FieldReduction pressureResidualReduction;
+  FieldReduction velocityReduction;
+  GpuTimerPool stageTimers;
+  TileActivityShader tileActivityShader;
+  ofFbo tileActivityFbo;
+  PboReadback tileActivityReadback;
+  std::vector<uint8_t> tileActivityReadbackData;
+  TileCoverage tileCoverage;
   SubtractDivergenceShader subtractDivergenceShader;
   VorticityRenderer vorticityRenderer;
   ApplyVorticityForceShader applyVorticityForceShader;
@@ -946,9 +2007,13 @@ public:
   ofFbo temperatureDiffusionSourceFbo;
   ApplyBouyancyShader applyBouyancyShader;
   ApplyTemperatureBuoyancyShader applyTemperatureBuoyancyShader;
+  FusedForcesShader fusedForcesShader;
   
   SoftCircleShader softCircleShader;
+  std::vector<SoftCircleShader::Stamp> dyeStampBatch;
   AddRadialImpulseShader addRadialImpulseShader;
+  AddRadialImpulsesShader addRadialImpulsesShader;
+  std::vector<AddRadialImpulsesShader::RadialImpulse> radialImpulseBatch;
 
   ParameterOverrides parameterOverrides_;
   DebugStepInfo debugStepInfo;
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ofTexture.h"
+#include "ofGLUtils.h"
+
+// Binary snapshot of a set of float textures, used by FluidSimulation::saveState/loadState.
+//
+// Layout (native byte order):
+//   char magic[8] = "OFXFLUID", uint32 version, uint32 fieldCount
+//   version 2: uint32 stateBytes; the caller's opaque state (see Writer::setState)
+//   per field: uint32 id, width, height, channels, precision, reserved; uint64 bytes; texels
+// Texels are tightly packed rows of `channels` float32 or float16 values in GL row order, so a
+// field can be handed to glTexSubImage2D directly (GL converts float16 on upload and download).
+namespace FluidStateFile {
+
+enum class Precision : uint32_t {
+  Float32 = 0,
+  Float16 = 1,
+};
+
+constexpr char MAGIC[8] = { 'O', 'F', 'X', 'F', 'L', 'U', 'I', 'D' };
+constexpr uint32_t VERSION = 2; // version 1 files (no state block) are still read
+
+struct FieldHeader {
+  uint32_t id;
+  uint32_t width;
+  uint32_t height;
+  uint32_t channels;
+  Precision precision;
+  uint32_t reserved;
+  uint64_t bytes;
+};
+
+inline GLenum getFormat(uint32_t channels) {
+  switch (channels) {
+    case 1: return GL_RED;
+    case 2: return GL_RG;
+    case 3: return GL_RGB;
+    default: return GL_RGBA;
+  }
+}
+
+inline GLenum getType(Precision precision) {
+  return precision == Precision::Float16 ? GL_HALF_FLOAT : GL_FLOAT;
+}
+
+inline uint64_t getByteCount(uint32_t width, uint32_t height, uint32_t channels, Precision precision) {
+  const uint64_t componentBytes = precision == Precision::Float16 ? 2 : 4;
+  return uint64_t(width) * height * channels * componentBytes;
+}
+
+// Reads textures back (synchronously) and writes them out as one file.
+class Writer {
+public:
+  // Keeps the first `channels` channels of texture.
+  void add(uint32_t id, const ofTexture& texture, uint32_t channels, Precision precision) {
+    const auto& data = texture.getTextureData();
+    Field field;
+    field.header = { id,
+                     static_cast<uint32_t>(texture.getWidth()),
+                     static_cast<uint32_t>(texture.getHeight()),
+                     channels,
+                     precision,
+                     0,
+                     0 };
+    field.header.bytes = getByteCount(field.header.width, field.header.height, channels, precision);
+    field.texels.resize(field.header.bytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindTexture(data.textureTarget, data.textureID);
+    glGetTexImage(data.textureTarget, 0, getFormat(channels), getType(precision), field.texels.data());
+    glBindTexture(data.textureTarget, 0);
+
+    fields.push_back(std::move(field));
+  }
+
+  // Stores bytes of non-texture state ahead of the fields.
+  void setState(const void* data, size_t bytes) {
+    const auto* begin = static_cast<const uint8_t*>(data);
+    state.assign(begin, begin + bytes);
+  }
+
+  bool write(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    const uint32_t fieldCount = static_cast<uint32_t>(fields.size());
+    const uint32_t stateBytes = static_cast<uint32_t>(state.size());
+    bool ok = std::fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1
+      && std::fwrite(&VERSION, sizeof(VERSION), 1, file) == 1
+      && std::fwrite(&fieldCount, sizeof(fieldCount), 1, file) == 1
+      && std::fwrite(&stateBytes, sizeof(stateBytes), 1, file) == 1
+      && std::fwrite(state.data(), 1, state.size(), file) == state.size();
+    for (const auto& field : fields) {
+      if (!ok) break;
+      ok = std::fwrite(&field.header, sizeof(field.header), 1, file) == 1
+        && std::fwrite(field.texels.data(), 1, field.texels.size(), file) == field.texels.size();
+    }
+    return (std::fclose(file) == 0) && ok;
+  }
+
+private:
+  struct Field {
+    FieldHeader header;
+    std::vector<uint8_t> texels;
+  };
+
+  std::vector<Field> fields;
+  std::vector<uint8_t> state;
+};
+
+// Maps a state file (read into memory where mmap isn't available) and uploads its fields
+// straight from the mapping.
+class Reader {
+public:
+  struct Field {
+    FieldHeader header;
+    const uint8_t* texels;
+  };
+
+  Reader() {}
+
+  ~Reader() { close(); }
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  bool open(const std::string& path) {
+    close();
+    if (!map(path)) {
+      error = "can't read " + path;
+      return false;
+    }
+
+    const uint8_t* cursor = bytes;
+    const uint8_t* end = bytes + size;
+    uint32_t version = 0;
+    uint32_t fieldCount = 0;
+    if (size < sizeof(MAGIC) + sizeof(version) + sizeof(fieldCount) || std::memcmp(cursor, MAGIC, sizeof(MAGIC)) != 0) {
+      error = path + " is not a fluid state file";
+      return false;
+    }
+    cursor += sizeof(MAGIC);
+    std::memcpy(&version, cursor, sizeof(version));
+    cursor += sizeof(version);
+    std::memcpy(&fieldCount, cursor, sizeof(fieldCount));
+    cursor += sizeof(fieldCount);
+    if (version != 1 && version != VERSION) {
+      error = path + " has unsupported version " + std::to_string(version);
+      return false;
+    }
+    if (version >= 2) {
+      uint32_t stateBytes = 0;
+      if (static_cast<size_t>(end - cursor) < sizeof(stateBytes)) {
+        error = path + " is truncated";
+        return false;
+      }
+      std::memcpy(&stateBytes, cursor, sizeof(stateBytes));
+      cursor += sizeof(stateBytes);
+      if (static_cast<size_t>(end - cursor) < stateBytes) {
+        error = path + " is truncated";
+        return false;
+      }
+      state = cursor;
+      stateSize = stateBytes;
+      cursor += stateBytes;
+    }
+
+    for (uint32_t i = 0; i < fieldCount; ++i) {
+      Field field;
+      if (static_cast<size_t>(end - cursor) < sizeof(FieldHeader)) {
+        error = path + " is truncated";
+        return false;
+      }
+      std::memcpy(&field.header, cursor, sizeof(FieldHeader));
+      cursor += sizeof(FieldHeader);
+      const auto& h = field.header;
+      if (h.channels < 1 || h.channels > 4
+          || h.bytes != getByteCount(h.width, h.height, h.channels, h.precision)
+          || static_cast<uint64_t>(end - cursor) < h.bytes) {
+        error = path + " has a malformed field " + std::to_string(h.id);
+        return false;
+      }
+      field.texels = cursor;
+      cursor += h.bytes;
+      fields.push_back(field);
+    }
+    return true;
+  }
+
+  const Field* find(uint32_t id) const {
+    for (const auto& field : fields) {
+      if (field.header.id == id) return &field;
+    }
+    return nullptr;
+  }
+
+  // Uploads field into texture, which must have the field's size. Channels the field doesn't
+  // carry are filled as glTexSubImage2D does (0, alpha 1).
+  static void upload(const Field& field, ofTexture& texture) {
+    const auto& data = texture.getTextureData();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(data.textureTarget, data.textureID);
+    glTexSubImage2D(data.textureTarget, 0, 0, 0,
+                    static_cast<GLsizei>(field.header.width), static_cast<GLsizei>(field.header.height),
+                    getFormat(field.header.channels), getType(field.header.precision), field.texels);
+    glBindTexture(data.textureTarget, 0);
+  }
+
+  // The Writer::setState() bytes; empty for version 1 files.
+  std::span<const uint8_t> getState() const { return { state, stateSize }; }
+
+  const std::string& getError() const { return error; }
+
+private:
+  bool map(const std::string& path) {
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+      ::close(fd);
+      return false;
+    }
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+    bytes = static_cast<const uint8_t*>(mapping);
+    size = static_cast<size_t>(info.st_size);
+    mapped = true;
+    return true;
+#else
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::fseek(file, 0, SEEK_END);
+    const long length = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if (length > 0) {
+      buffer.resize(static_cast<size_t>(length));
+      if (std::fread(buffer.data(), 1, buffer.size(), file) != buffer.size()) buffer.clear();
+    }
+    std::fclose(file);
+    if (buffer.empty()) return false;
+    bytes = buffer.data();
+    size = buffer.size();
+    return true;
+#endif
+  }
+
+  void close() {
+#ifndef _WIN32
+    if (mapped) ::munmap(const_cast<uint8_t*>(bytes), size);
+#endif
+    mapped = false;
+    bytes = nullptr;
+    size = 0;
+    state = nullptr;
+    stateSize = 0;
+    buffer.clear();
+    fields.clear();
+    error.clear();
+  }
+
+  const uint8_t* bytes = nullptr;
+  size_t size = 0;
+  const uint8_t* state = nullptr;
+  size_t stateSize = 0;
+  bool mapped = false;
+  std::vector<uint8_t> buffer;
+  std::vector<Field> fields;
+  std::string error;
+};
+
+} // namespace FluidStateFile
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "Shader.h"
+
+// The force stage of FluidSimulation::update in a single pass. Per cell it computes the same
+// arithmetic, in the same order, as this chain of passes:
+//   VorticityRenderer -> ApplyVorticityForceShader -> VelocityBoundaryShader -> VelocityCflClampShader
+//   -> ApplyBouyancyShader or ApplyTemperatureBuoyancyShader -> VelocityBoundaryShader -> VelocityCflClampShader
+// The curl is evaluated in-register at the cell and its four neighbours from the incoming
+// velocities, so no curl texture is written. A neighbour past the field edge is read the way the
+// curl texture would be with curlWrap: GL_REPEAT wraps it, anything else clamps it to the edge
+// cell. Everything after confinement is point-wise, so the fused result matches the chain up to
+// float rounding (outside tiled mode, where the chain's curl texture is stale between tiles).
+class FusedForcesShader : public Shader {
+
+public:
+  enum BuoyancyMode {
+    BUOYANCY_NONE = 0,
+    BUOYANCY_DENSITY = 1,     // ApplyBouyancyShader: density from values
+    BUOYANCY_TEMPERATURE = 2, // ApplyTemperatureBuoyancyShader
+  };
+
+  struct Buoyancy {
+    int mode = BUOYANCY_NONE;
+    float strength = 0.0f;
+    float densityScale = 1.0f;
+    float densityThreshold = 0.0f;
+    float ambientTemperature = 0.0f;
+    float temperatureThreshold = 0.0f;
+    glm::vec2 gravityForce { 0.0f, -1.0f };
+  };
+
+  // source is the values (density) or temperatures texture, depending on buoyancy.mode.
+  // maxDisp is the CFL clamp in UV units (see VelocityCflClampShader). curlWrap is the wrap mode
+  // the chain's curl texture would have.
+  void render(PingPongFbo& velocities,
+              float vorticityStrength,
+              float dt,
+              float maxDisp,
+              bool wallBoundary,
+              GLint curlWrap,
+              const Buoyancy& buoyancy,
+              const ofTexture& buoyancySource,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    {
+      const auto texSize = glm::vec2(velocities.getWidth(), velocities.getHeight());
+      shader.setUniformTexture("buoyancySource", buoyancySource, 1);
+      shader.setUniformTexture("obstacles", obstacleMask, 2);
+      shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
+      shader.setUniform2f("texSize", texSize);
+      shader.setUniform2f("halfInvCell", 0.5f * texSize);
+      shader.setUniform1f("dt", dt);
+      shader.setUniform1f("vorticityStrength", vorticityStrength);
+      shader.setUniform1f("maxDisp", maxDisp);
+      shader.setUniform1i("wallBoundary", wallBoundary ? 1 : 0);
+      shader.setUniform1i("clampCurl", curlWrap == GL_REPEAT ? 0 : 1);
+      const int buoyancyMode = (buoyancy.strength == 0.0f) ? BUOYANCY_NONE : buoyancy.mode;
+      shader.setUniform1i("buoyancyMode", buoyancyMode);
+      shader.setUniform1f("buoyancyStrength", buoyancy.strength);
+      shader.setUniform1f("densityScale", buoyancy.densityScale);
+      shader.setUniform1f("densityThreshold", buoyancy.densityThreshold);
+      shader.setUniform1f("ambientTemperature", buoyancy.ambientTemperature);
+      shader.setUniform1f("temperatureThreshold", buoyancy.temperatureThreshold);
+      shader.setUniform2f("gravityForce", buoyancy.gravityForce);
+      drawPass(velocities.getTarget(), velocities.getSource().getTexture());
+    }
+    shader.end();
+    velocities.swap();
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0; // velocities
+                uniform sampler2D buoyancySource;
+                uniform sampler2D obstacles; // ObstacleMaskRenderer output
+                uniform int obstaclesEnabled;
+                uniform vec2 texSize;
+                uniform vec2 halfInvCell;
+                uniform float dt;
+                uniform float vorticityStrength;
+                uniform float maxDisp;
+                uniform int wallBoundary;
+                uniform int clampCurl;
+                uniform int buoyancyMode;
+                uniform float buoyancyStrength;
+                uniform float densityScale;
+                uniform float densityThreshold;
+                uniform float ambientTemperature;
+                uniform float temperatureThreshold;
+                uniform vec2 gravityForce;
+                in vec2 texCoordVarying;
+                out vec4 fragColor;
+
+                // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                int obstacleBits(vec2 uv) {
+                  if (obstaclesEnabled == 0) return 0;
+                  return int(texture(obstacles, uv).r * 255.0 + 0.5);
+                }
+
+                float obstacleSolid(vec2 uv) {
+                  return float(obstacleBits(uv) & 1);
+                }
+
+                // As VorticityRenderer.
+                float curlAt(vec2 uv, vec2 off) {
+                  vec2 vN = texture(tex0, uv + off.yx).xy;
+                  vec2 vS = texture(tex0, uv - off.yx).xy;
+                  vec2 vE = texture(tex0, uv + off.xy).xy;
+                  vec2 vW = texture(tex0, uv - off.xy).xy;
+                  return (vE.y - vW.y) * halfInvCell.x - (vN.x - vS.x) * halfInvCell.y;
+                }
+
+                // Where the chain reads a neighbour's curl: repeating taps already wrap, and a
+                // clamped curl texture returns the edge cell's curl.
+                vec2 curlCell(vec2 uv) {
+                  if (clampCurl == 0) return uv;
+                  vec2 halfTexel = 0.5 / texSize;
+                  return clamp(uv, halfTexel, 1.0 - halfTexel);
+                }
+
+                // As VelocityBoundaryShader.
+                vec2 applyWalls(vec2 v, vec2 uv) {
+                  if (wallBoundary == 0) return v;
+                  vec2 p = uv * texSize;
+                  if (p.x < 1.5 || p.x > texSize.x - 1.5) v.x = 0.0;
+                  if (p.y < 1.5 || p.y > texSize.y - 1.5) v.y = 0.0;
+                  return v;
+                }
+
+                // As VelocityCflClampShader.
+                vec2 clampCfl(vec2 v) {
+                  float disp = length(v) * dt;
+                  if (disp > maxDisp && disp > 0.0) {
+                    v *= maxDisp / disp;
+                  }
+                  return v;
+                }
+
+                float signedThreshold(float v, float threshold) {
+                  float s = (v < 0.0) ? -1.0 : 1.0;
+                  float mag = max(abs(v) - threshold, 0.0);
+                  return s * mag;
+                }
+
+                void main() {
+                  vec2 xy = texCoordVarying.xy;
+
+                  if (obstacleSolid(xy) > 0.5) {
+                    fragColor = vec4(0.0);
+                    return;
+                  }
+
+                  vec2 v = texture(tex0, xy).xy;
+
+                  // Vorticity confinement (ApplyVorticityForceShader)
+                  vec2 off = vec2(1.0, 0.0) / texSize;
+                  float curlN = abs(curlAt(curlCell(xy + off.yx), off));
+                  float curlS = abs(curlAt(curlCell(xy - off.yx), off));
+                  float curlE = abs(curlAt(curlCell(xy + off.xy), off));
+                  float curlW = abs(curlAt(curlCell(xy - off.xy), off));
+                  float curlC = curlAt(xy, off);
+
+                  vec2 grad = vec2(curlE - curlW, curlN - curlS) * halfInvCell;
+                  float gradLen = length(grad);
+                  vec2 N = (gradLen > 1e-6) ? (grad / gradLen) : vec2(0.0);
+                  v += vec2(N.y, -N.x) * curlC * dt * vorticityStrength;
+
+                  v = clampCfl(applyWalls(v, xy));
+
+                  if (buoyancyMode != 0) {
+                    vec4 s = texture(buoyancySource, xy);
+                    float amount;
+                    if (buoyancyMode == 1) {
+                      float density = max(s.a, dot(s.rgb, vec3(0.333333)));
+                      amount = max(0.0, densityScale * (density - densityThreshold));
+                    } else {
+                      amount = signedThreshold(s.r - ambientTemperature, temperatureThreshold);
+                    }
+                    v += dt * buoyancyStrength * amount * gravityForce;
+                    v = clampCfl(applyWalls(v, xy));
+                  }
+
+                  fragColor = vec4(v, 0.0, 0.0);
+                }
+                );
+  }
+};
@@ -1,15 +1,30 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
 #include "Shader.h"
+#include "ObstacleMaskRenderer.h"
 
 class JacobiShader : public Shader {
 
 public:
+  ~JacobiShader() override {
+    for (auto& solve : pendingAdaptiveSolves) {
+      glDeleteQueries(static_cast<GLsizei>(solve.queries.size()), solve.queries.data());
+    }
+    if (!freeQueries.empty()) glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+  }
+
   void render(PingPongFbo& x, const ofTexture& b, float dt, float alpha, float rBeta, int iterations) {
     // Backwards-compatible path: obstacles disabled.
-    render(x, b, dt, alpha, rBeta, iterations, x.getSource().getTexture(), false, 0.5f, false);
+    render(x, b, dt, alpha, rBeta, iterations, x.getSource().getTexture(), false);
   }
 
+  // Thresholds obstacles into a mask on every call; see ObstacleMaskRenderer::buildShared().
+  [[deprecated("pass an ObstacleMaskRenderer mask and obstaclesEnabled instead")]]
   void render(PingPongFbo& x,
               const ofTexture& b,
               float dt,
@@ -20,29 +35,121 @@ public:
               bool obstaclesEnabled,
               float obstacleThreshold,
               bool obstacleInvert) {
+    render(x,
+           b,
+           dt,
+           alpha,
+           rBeta,
+           iterations,
+           obstaclesEnabled ? ObstacleMaskRenderer::buildShared(obstacles, x.getWidth(), x.getHeight(), obstacleThreshold, obstacleInvert) : obstacles,
+           obstaclesEnabled);
+  }
+
+  void render(PingPongFbo& x,
+              const ofTexture& b,
+              float dt,
+              float alpha,
+              float rBeta,
+              int iterations,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled,
+              float weight = 1.0f) {
     (void)dt; // kept for API consistency (pressure/diffusion are dt-dependent at higher layers)
 
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
     shader.begin();
     shader.setUniformTexture("b", b, 1);
-    shader.setUniformTexture("obstacles", obstacles, 2);
+    shader.setUniformTexture("obstacles", obstacleMask, 2);
     shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
-    shader.setUniform1f("obstacleThreshold", obstacleThreshold);
-    shader.setUniform1i("obstacleInvert", obstacleInvert ? 1 : 0);
     shader.setUniform2f("texSize", glm::vec2(x.getSource().getWidth(), x.getSource().getHeight()));
     shader.setUniform1f("alpha", alpha);
     shader.setUniform1f("rBeta", rBeta);
+    shader.setUniform1f("weight", weight);
+    shader.setUniform1i("testMode", 0);
     for (int i = 0; i < iterations; i++) {
-      x.getTarget().begin();
-      x.getSource().draw(0, 0);
-      x.getTarget().end();
+      drawPass(x.getTarget(), x.getSource().getTexture());
       x.swap();
     }
     shader.end();
     ofPopStyle();
   }
 
+  // Like render(), but before every block of checkInterval iterations a test pass counts (with an
+  // occlusion query) the cells whose Jacobi update still exceeds tolerance, and the block is
+  // conditionally rendered on that count. Once the field has converged the remaining blocks are
+  // skipped on the GPU without a CPU round trip.
+  // tolerance is in units of b (e.g. divergence for the pressure solve). Blocks are an even number
+  // of iterations so skipped blocks leave the ping-pong source where the CPU expects it; maxIterations
+  // is rounded up accordingly. The number of iterations actually run becomes available through
+  // getLastAdaptiveIterations() a frame or two later.
+  void renderAdaptive(PingPongFbo& x,
+                      const ofTexture& b,
+                      float dt,
+                      float alpha,
+                      float rBeta,
+                      int maxIterations,
+                      float tolerance,
+                      int checkInterval,
+                      const ofTexture& obstacleMask,
+                      bool obstaclesEnabled) {
+    (void)dt;
+    collectAdaptiveResults();
+    if (maxIterations <= 0) return;
+
+    const int blockSize = std::max(2, checkInterval + (checkInterval & 1));
+    // Update size per cell that corresponds to a residual of `tolerance` in b.
+    const float updateThreshold = tolerance * std::abs(alpha * rBeta);
+
+    PendingAdaptiveSolve solve;
+
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    shader.setUniformTexture("b", b, 1);
+    shader.setUniformTexture("obstacles", obstacleMask, 2);
+    shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
+    shader.setUniform2f("texSize", glm::vec2(x.getSource().getWidth(), x.getSource().getHeight()));
+    shader.setUniform1f("alpha", alpha);
+    shader.setUniform1f("rBeta", rBeta);
+    shader.setUniform1f("weight", 1.0f);
+    shader.setUniform1f("convergenceThreshold", updateThreshold);
+    shader.setUniform4f("convergenceChannels", getChannelMask(x.getSource().getTexture()));
+
+    GLuint previousQuery = 0;
+    for (int done = 0; done < maxIterations; done += blockSize) {
+      // Test pass: no color writes, converged fragments discard, so the query counts unconverged cells.
+      const GLuint query = acquireQuery();
+      if (previousQuery) glBeginConditionalRender(previousQuery, GL_QUERY_WAIT);
+      glBeginQuery(GL_SAMPLES_PASSED, query);
+      shader.setUniform1i("testMode", 1);
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      drawPass(x.getTarget(), x.getSource().getTexture());
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      glEndQuery(GL_SAMPLES_PASSED);
+      if (previousQuery) glEndConditionalRender();
+
+      shader.setUniform1i("testMode", 0);
+      glBeginConditionalRender(query, GL_QUERY_WAIT);
+      for (int i = 0; i < blockSize; i++) {
+        drawPass(x.getTarget(), x.getSource().getTexture());
+        x.swap();
+      }
+      glEndConditionalRender();
+
+      solve.queries.push_back(query);
+      previousQuery = query;
+    }
+    solve.blockSize = blockSize;
+    pendingAdaptiveSolves.push_back(std::move(solve));
+
+    shader.end();
+    ofPopStyle();
+  }
+
+  // Iterations run by the most recent adaptive solve whose queries have completed, or -1 if none has yet.
+  int getLastAdaptiveIterations() const { return lastAdaptiveIterations; }
+
   static ofParameter<int> createIterationsParameter(const std::string& prefix, int value=20) {
     return ofParameter<int> { prefix+"Iterations", value, 0, 30 };
   }
@@ -52,34 +159,41 @@ protected:
     return GLSL(
                 uniform sampler2D tex0; // current values
                 uniform sampler2D b;
-                uniform sampler2D obstacles;
+                uniform sampler2D obstacles; // ObstacleMaskRenderer output
                 uniform int obstaclesEnabled;
-                uniform float obstacleThreshold;
-                uniform int obstacleInvert;
                 uniform vec2 texSize;
                 uniform float alpha;
                 uniform float rBeta;
+                uniform float weight; // < 1 for damped Jacobi (multigrid smoothing)
+                uniform int testMode; // 1: discard converged fragments (see renderAdaptive)
+                uniform float convergenceThreshold;
+                uniform vec4 convergenceChannels;
                 in vec2 texCoordVarying;
                 out vec4 fragColor;
 
-                float obstacleMask(vec2 uv) {
-                  vec2 sz = vec2(textureSize(obstacles, 0));
-                  vec2 uvQ = (floor(uv * sz) + 0.5) / sz;
-                  vec4 o = texture(obstacles, uvQ);
-                  float m = max(o.a, dot(o.rgb, vec3(0.333333)));
-                  if (obstacleInvert == 1) m = 1.0 - m;
-                  return m;
+                // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                int obstacleBits(vec2 uv) {
+                  if (obstaclesEnabled == 0) return 0;
+                  return int(texture(obstacles, uv).r * 255.0 + 0.5);
                 }
 
                 float obstacleSolid(vec2 uv) {
-                  if (obstaclesEnabled == 0) return 0.0;
-                  return step(obstacleThreshold, obstacleMask(uv));
+                  return float(obstacleBits(uv) & 1);
+                }
+
+                // Neighbour solidity from the centre's mask bits when the mask matches this grid,
+                // otherwise (multigrid coarse levels) by sampling the mask at the neighbour.
+                bool neighborSolid(int bits, int bit, vec2 uv) {
+                  if (textureSize(obstacles, 0) == ivec2(texSize)) return (bits & bit) != 0;
+                  return obstacleSolid(uv) > 0.5;
                 }
 
                 void main() {
                   vec2 xy = texCoordVarying.xy;
 
-                  if (obstacleSolid(xy) > 0.5) {
+                  int bits = obstacleBits(xy);
+                  if ((bits & 1) != 0) {
+                    if (testMode == 1) discard;
                     fragColor = vec4(0.0);
                     return;
                   }
@@ -93,15 +207,72 @@ protected:
                   vec4 xE = texture(tex0, xy + off.xy);
                   vec4 xW = texture(tex0, xy - off.xy);
 
-                  if (obstacleSolid(xy + off.yx) > 0.5) xN = xC;
-                  if (obstacleSolid(xy - off.yx) > 0.5) xS = xC;
-                  if (obstacleSolid(xy + off.xy) > 0.5) xE = xC;
-                  if (obstacleSolid(xy - off.xy) > 0.5) xW = xC;
+                  if (neighborSolid(bits, 2, xy + off.yx)) xN = xC;
+                  if (neighborSolid(bits, 4, xy - off.yx)) xS = xC;
+                  if (neighborSolid(bits, 8, xy + off.xy)) xE = xC;
+                  if (neighborSolid(bits, 16, xy - off.xy)) xW = xC;
 
                   vec4 bC = texture(b, xy);
 
-                  fragColor = (xW + xE + xS + xN + alpha * bC) * rBeta;
+                  vec4 xJ = (xW + xE + xS + xN + alpha * bC) * rBeta;
+                  if (testMode == 1) {
+                    vec4 update = abs(xJ - xC) * convergenceChannels;
+                    if (max(max(update.r, update.g), max(update.b, update.a)) <= convergenceThreshold) discard;
+                  }
+                  fragColor = (weight == 1.0) ? xJ : mix(xC, xJ, weight);
                 }
                 );
   }
+
+private:
+  struct PendingAdaptiveSolve {
+    std::vector<GLuint> queries; // one per block, in order
+    int blockSize = 0;
+  };
+
+  // Channels that are actually stored (e.g. alpha of an RGB texture always reads back as 1).
+  static glm::vec4 getChannelMask(const ofTexture& texture) {
+    switch (texture.getTextureData().glInternalFormat) {
+      case GL_R8: case GL_R16F: case GL_R32F: return { 1.0f, 0.0f, 0.0f, 0.0f };
+      case GL_RG8: case GL_RG16F: case GL_RG32F: return { 1.0f, 1.0f, 0.0f, 0.0f };
+      case GL_RGB8: case GL_RGB16F: case GL_RGB32F: return { 1.0f, 1.0f, 1.0f, 0.0f };
+      default: return { 1.0f, 1.0f, 1.0f, 1.0f };
+    }
+  }
+
+  GLuint acquireQuery() {
+    if (freeQueries.empty()) {
+      GLuint query = 0;
+      glGenQueries(1, &query);
+      return query;
+    }
+    const GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+  }
+
+  // Reads back finished solves without blocking: a block ran iff its test query passed samples.
+  void collectAdaptiveResults() {
+    while (!pendingAdaptiveSolves.empty()) {
+      auto& solve = pendingAdaptiveSolves.front();
+      GLuint available = 0;
+      glGetQueryObjectuiv(solve.queries.back(), GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available) break;
+
+      int iterations = 0;
+      for (GLuint query : solve.queries) {
+        GLuint samples = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samples);
+        if (samples > 0) iterations += solve.blockSize;
+      }
+      lastAdaptiveIterations = iterations;
+
+      freeQueries.insert(freeQueries.end(), solve.queries.begin(), solve.queries.end());
+      pendingAdaptiveSolves.pop_front();
+    }
+  }
+
+  std::deque<PendingAdaptiveSolve> pendingAdaptiveSolves;
+  std::vector<GLuint> freeQueries;
+  int lastAdaptiveIterations = -1;
 };
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Shader.h"
+
+// Adds the bilinearly interpolated coarse-grid correction to a fine-grid solution.
+class MultigridProlongateShader : public Shader {
+
+public:
+  void render(PingPongFbo& fine, const ofTexture& coarseCorrection) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    shader.setUniformTexture("correction", coarseCorrection, 1);
+    drawPass(fine.getTarget(), fine.getSource().getTexture());
+    shader.end();
+    fine.swap();
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0; // fine solution
+                uniform sampler2D correction;
+                in vec2 texCoordVarying;
+                out vec4 fragColor;
+
+                void main() {
+                  vec2 xy = texCoordVarying.xy;
+                  vec4 x = texture(tex0, xy);
+                  fragColor = vec4(x.r + texture(correction, xy).r, x.gba);
+                }
+                );
+  }
+};
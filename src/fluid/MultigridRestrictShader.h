@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Shader.h"
+
+// Restricts a fine-grid residual onto the next coarser grid. With linear filtering each coarse
+// texel centre lands on the shared corner of its 2x2 fine texels, so one tap is their average.
+class MultigridRestrictShader : public Shader {
+
+public:
+  void render(ofFbo& coarse, const ofFbo& fine) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    drawPass(coarse, fine.getTexture());
+    shader.end();
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0; // fine residual
+                in vec2 texCoordVarying;
+                out vec4 fragColor;
+
+                void main() {
+                  fragColor = vec4(texture(tex0, texCoordVarying.xy).r, 0.0, 0.0, 0.0);
+                }
+                );
+  }
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "Renderer.h"
+
+// Thresholds an obstacle texture once into a compact per-cell mask for the fluid passes:
+// bit 1 = cell solid, bits 2/4/8/16 = the N/S/E/W neighbour is solid.
+// Stored as GL_R8 (bits / 255) with NEAREST filtering so it attaches to an ordinary ofFbo;
+// shaders decode with int(texture(mask, uv).r * 255.0 + 0.5).
+class ObstacleMaskRenderer : public Renderer {
+
+public:
+  static constexpr int SOLID = 1;
+  static constexpr int NORTH = 2;
+  static constexpr int SOUTH = 4;
+  static constexpr int EAST = 8;
+  static constexpr int WEST = 16;
+
+  void allocate(float width_, float height_) {
+    Renderer::allocate(width_, height_);
+    fbo.getTexture().setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+  }
+
+  void render(const ofTexture& obstacles, float threshold, bool invert) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    {
+      shader.setUniform2f("texSize", glm::vec2(fbo.getWidth(), fbo.getHeight()));
+      shader.setUniform1f("obstacleThreshold", threshold);
+      shader.setUniform1i("obstacleInvert", invert ? 1 : 0);
+      drawPass(fbo, obstacles);
+    }
+    shader.end();
+    ofPopStyle();
+  }
+
+  const ofTexture& getTexture() const { return fbo.getTexture(); }
+
+  // Builds a width x height mask of obstacles and returns it, for the deprecated
+  // (obstacles, enabled, threshold, invert) overloads of the fluid shaders. One shared renderer
+  // per size, rebuilt on every call, so the texture is only good until the next call at that size.
+  static const ofTexture& buildShared(const ofTexture& obstacles, float width_, float height_, float threshold, bool invert) {
+    // Deliberately never destroyed, like the shared FullscreenTriangle: they hold GL objects.
+    static auto* shared = new std::map<std::pair<int, int>, std::unique_ptr<ObstacleMaskRenderer>>();
+    auto& renderer = (*shared)[{ static_cast<int>(width_), static_cast<int>(height_) }];
+    if (!renderer) {
+      renderer = std::make_unique<ObstacleMaskRenderer>();
+      renderer->load();
+      renderer->allocate(width_, height_);
+    }
+    renderer->render(obstacles, threshold, invert);
+    return renderer->getTexture();
+  }
+
+protected:
+  GLint getInternalFormat() override { return GL_R8; }
+
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0; // obstacles
+                uniform vec2 texSize; // mask size
+                uniform float obstacleThreshold;
+                uniform int obstacleInvert;
+                in vec2 texCoordVarying;
+                out vec4 fragColor;
+
+                float obstacleMask(vec2 uv) {
+                  vec2 sz = vec2(textureSize(tex0, 0));
+                  vec2 uvQ = (floor(uv * sz) + 0.5) / sz;
+                  vec4 o = texture(tex0, uvQ);
+                  float m = max(o.a, dot(o.rgb, vec3(0.333333)));
+                  if (obstacleInvert == 1) m = 1.0 - m;
+                  return m;
+                }
+
+                int obstacleSolid(vec2 uv) {
+                  return int(step(obstacleThreshold, obstacleMask(uv)));
+                }
+
+                void main() {
+                  vec2 xy = texCoordVarying.xy;
+                  vec2 off = vec2(1.0, 0.0) / texSize;
+
+                  int bits = obstacleSolid(xy);
+                  bits |= obstacleSolid(xy + off.yx) * 2;
+                  bits |= obstacleSolid(xy - off.yx) * 4;
+                  bits |= obstacleSolid(xy + off.xy) * 8;
+                  bits |= obstacleSolid(xy - off.xy) * 16;
+
+                  fragColor = vec4(float(bits) / 255.0, 0.0, 0.0, 1.0);
+                }
+                );
+  }
+};
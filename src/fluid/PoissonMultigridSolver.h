@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "ofFbo.h"
+#include "PingPongFbo.h"
+#include "JacobiShader.h"
+#include "PoissonResidualShader.h"
+#include "MultigridRestrictShader.h"
+#include "MultigridProlongateShader.h"
+
+// Geometric multigrid V-cycles for the pressure Poisson equation Laplacian(p) = divergence.
+// Level 0 is the caller's pressure buffer; each coarser level halves the resolution down to
+// MIN_LEVEL_SIZE. Every level is smoothed with damped Jacobi, the residual is restricted to the
+// next level, solved there recursively and the correction prolongated back. Low-frequency
+// divergence that full-res Jacobi needs hundreds of passes for is removed on the coarse levels.
+class PoissonMultigridSolver {
+
+public:
+  static constexpr int MAX_LEVELS = 10;
+  static constexpr int MIN_LEVEL_SIZE = 4;
+  static constexpr int PRE_SMOOTH_ITERATIONS = 2;
+  static constexpr int POST_SMOOTH_ITERATIONS = 2;
+  static constexpr int COARSEST_ITERATIONS = 16;
+  static constexpr float SMOOTHING_WEIGHT = 0.8f;
+
+  static ofParameter<int> createVCyclesParameter(const std::string& prefix, int value=2) {
+    return ofParameter<int> { prefix+"V-Cycles", value, 1, 6 };
+  }
+
+  void load() {
+    smoother.load();
+    residualShader.load();
+    restrictShader.load();
+    prolongateShader.load();
+  }
+
+  void setPassMode(Shader::PassMode passMode) {
+    smoother.setPassMode(passMode);
+    residualShader.setPassMode(passMode);
+    restrictShader.setPassMode(passMode);
+    prolongateShader.setPassMode(passMode);
+  }
+
+  // Builds the coarse levels for a level-0 grid of width x height.
+  void allocate(int width, int height, GLint wrap) {
+    levels.clear();
+    int w = width;
+    int h = height;
+    for (int i = 0; i < MAX_LEVELS; ++i) {
+      auto level = std::make_unique<Level>();
+      level->width = w;
+      level->height = h;
+      // Level 0 solves in place in the caller's buffer against the caller's right-hand side.
+      if (i > 0) {
+        level->x.allocate(glm::vec2(w, h), GL_R32F, wrap);
+        level->x.clearFloat(0.0f, 0.0f, 0.0f, 0.0f);
+        level->b.allocate(createSettings(w, h, wrap));
+      }
+      const bool coarsest = std::min(w, h) <= MIN_LEVEL_SIZE || i == MAX_LEVELS - 1;
+      if (!coarsest) level->residual.allocate(createSettings(w, h, wrap));
+      levels.push_back(std::move(level));
+      if (coarsest) break;
+      w = std::max(1, (w + 1) / 2);
+      h = std::max(1, (h + 1) / 2);
+    }
+  }
+
+  void setWrap(GLint wrap) {
+    for (auto& level : levels) {
+      for (ofFbo* fbo : { &level->x.getSource(), &level->x.getTarget(), &level->b, &level->residual }) {
+        if (fbo->isAllocated()) fbo->getTexture().setTextureWrap(wrap, wrap);
+      }
+    }
+  }
+
+  bool isAllocated() const { return !levels.empty(); }
+  int getNumLevels() const { return static_cast<int>(levels.size()); }
+
+  // Runs vCycles V-cycles on x (warm-started from its current contents) for Laplacian(x) = b,
+  // where dx is the level-0 cell size in the same units JacobiShader's alpha uses.
+  void solve(PingPongFbo& x,
+             const ofTexture& b,
+             float dx,
+             int vCycles,
+             const ofTexture& obstacleMask,
+             bool obstaclesEnabled) {
+    if (levels.empty()) return;
+    for (int i = 0; i < vCycles; ++i) {
+      vCycle(0, x, b, dx, obstacleMask, obstaclesEnabled);
+    }
+  }
+
+private:
+  struct Level {
+    int width = 0;
+    int height = 0;
+    PingPongFbo x;  // correction (unused on level 0)
+    ofFbo b;        // restricted residual (unused on level 0)
+    ofFbo residual; // unused on the coarsest level
+  };
+
+  static ofFboSettings createSettings(int width, int height, GLint wrap) {
+    ofFboSettings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.internalformat = GL_R32F;
+    settings.useDepth = false;
+    settings.useStencil = false;
+    settings.textureTarget = GL_TEXTURE_2D;
+    settings.wrapModeHorizontal = wrap;
+    settings.wrapModeVertical = wrap;
+    return settings;
+  }
+
+  void smooth(PingPongFbo& x, const ofTexture& b, float dx, int iterations,
+              const ofTexture& obstacleMask, bool obstaclesEnabled) {
+    smoother.render(x, b, 0.0f, -(dx * dx), 0.25f, iterations,
+                    obstacleMask, obstaclesEnabled, SMOOTHING_WEIGHT);
+  }
+
+  void vCycle(size_t levelIndex,
+              PingPongFbo& x,
+              const ofTexture& b,
+              float dx,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
+    Level& level = *levels[levelIndex];
+
+    if (levelIndex + 1 == levels.size()) {
+      smooth(x, b, dx, COARSEST_ITERATIONS, obstacleMask, obstaclesEnabled);
+      return;
+    }
+
+    smooth(x, b, dx, PRE_SMOOTH_ITERATIONS, obstacleMask, obstaclesEnabled);
+    residualShader.render(level.residual, x.getSource(), b, dx, obstacleMask, obstaclesEnabled);
+
+    Level& coarse = *levels[levelIndex + 1];
+    restrictShader.render(coarse.b, level.residual);
+    clearSource(coarse.x);
+    const float coarseDx = dx * static_cast<float>(level.width) / static_cast<float>(coarse.width);
+    vCycle(levelIndex + 1, coarse.x, coarse.b.getTexture(), coarseDx, obstacleMask, obstaclesEnabled);
+
+    prolongateShader.render(x, coarse.x.getSource().getTexture());
+    smooth(x, b, dx, POST_SMOOTH_ITERATIONS, obstacleMask, obstaclesEnabled);
+  }
+
+  static void clearSource(PingPongFbo& x) {
+    OFXRENDERER_GL_COUNT_FOR(PoissonMultigridSolver, fboBinds, 2);
+    OFXRENDERER_GL_COUNT_FOR(PoissonMultigridSolver, clears, 1);
+    x.getSource().begin();
+    x.getSource().clearColorBuffer(ofFloatColor(0.0f, 0.0f, 0.0f, 0.0f));
+    x.getSource().end();
+  }
+
+  std::vector<std::unique_ptr<Level>> levels;
+  JacobiShader smoother;
+  PoissonResidualShader residualShader;
+  MultigridRestrictShader restrictShader;
+  MultigridProlongateShader prolongateShader;
+};
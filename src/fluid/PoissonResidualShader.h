@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Shader.h"
+
+// Writes r = b - Laplacian(x) for the pressure Poisson equation, using the same 5-point stencil
+// and obstacle handling as JacobiShader (solid neighbours mirror the centre value).
+class PoissonResidualShader : public Shader {
+
+public:
+  void render(ofFbo& residual, const ofFbo& x, const ofTexture& b, float dx) {
+    // Backwards-compatible path: obstacles disabled.
+    render(residual, x, b, dx, x.getTexture(), false);
+  }
+
+  void render(ofFbo& residual,
+              const ofFbo& x,
+              const ofTexture& b,
+              float dx,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    shader.setUniformTexture("b", b, 1);
+    shader.setUniformTexture("obstacles", obstacleMask, 2);
+    shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
+    shader.setUniform2f("texSize", glm::vec2(x.getWidth(), x.getHeight()));
+    shader.setUniform1f("invDx2", 1.0f / (dx * dx));
+    drawPass(residual, x.getTexture());
+    shader.end();
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0; // x
+                uniform sampler2D b;
+                uniform sampler2D obstacles; // ObstacleMaskRenderer output
+                uniform int obstaclesEnabled;
+                uniform vec2 texSize;
+                uniform float invDx2;
+                in vec2 texCoordVarying;
+                out vec4 fragColor;
+
+                // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                int obstacleBits(vec2 uv) {
+                  if (obstaclesEnabled == 0) return 0;
+                  return int(texture(obstacles, uv).r * 255.0 + 0.5);
+                }
+
+                float obstacleSolid(vec2 uv) {
+                  return float(obstacleBits(uv) & 1);
+                }
+
+                // Neighbour solidity from the centre's mask bits when the mask matches this grid,
+                // otherwise (multigrid coarse levels) by sampling the mask at the neighbour.
+                bool neighborSolid(int bits, int bit, vec2 uv) {
+                  if (textureSize(obstacles, 0) == ivec2(texSize)) return (bits & bit) != 0;
+                  return obstacleSolid(uv) > 0.5;
+                }
+
+                void main() {
+                  vec2 xy = texCoordVarying.xy;
+
+                  int bits = obstacleBits(xy);
+                  if ((bits & 1) != 0) {
+                    fragColor = vec4(0.0);
+                    return;
+                  }
+
+                  vec2 off = vec2(1.0, 0.0) / texSize;
+
+                  float xC = texture(tex0, xy).r;
+
+                  float xN = texture(tex0, xy + off.yx).r;
+                  float xS = texture(tex0, xy - off.yx).r;
+                  float xE = texture(tex0, xy + off.xy).r;
+                  float xW = texture(tex0, xy - off.xy).r;
+
+                  if (neighborSolid(bits, 2, xy + off.yx)) xN = xC;
+                  if (neighborSolid(bits, 4, xy - off.yx)) xS = xC;
+                  if (neighborSolid(bits, 8, xy + off.xy)) xE = xC;
+                  if (neighborSolid(bits, 16, xy - off.xy)) xW = xC;
+
+                  float laplacian = (xN + xS + xE + xW - 4.0 * xC) * invDx2;
+                  fragColor = vec4(texture(b, xy).r - laplacian, 0.0, 0.0, 0.0);
+                }
+                );
+  }
+};
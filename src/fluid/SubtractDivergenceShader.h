@@ -1,39 +1,53 @@
 #pragma once
 
 #include "Shader.h"
+#include "ObstacleMaskRenderer.h"
 
 class SubtractDivergenceShader : public Shader {
 
 public:
+  // Also applies the solid-wall boundary in the same pass, which saves the separate
+  // VelocityBoundaryShader pass.
+  void setFusedWallBoundary(bool fusedWallBoundary_) { fusedWallBoundary = fusedWallBoundary_; }
+
   void render(PingPongFbo& velocities_, ofFbo& pressures_) {
     // Backwards-compatible path: obstacles disabled.
-    render(velocities_, pressures_, velocities_.getSource().getTexture(), false, 0.5f, false);
+    render(velocities_, pressures_, velocities_.getSource().getTexture(), false);
   }
 
+  // Thresholds obstacles into a mask on every call; see ObstacleMaskRenderer::buildShared().
+  [[deprecated("pass an ObstacleMaskRenderer mask and obstaclesEnabled instead")]]
   void render(PingPongFbo& velocities_,
               ofFbo& pressures_,
               const ofTexture& obstacles,
               bool obstaclesEnabled,
               float obstacleThreshold,
               bool obstacleInvert) {
+    render(velocities_,
+           pressures_,
+           obstaclesEnabled ? ObstacleMaskRenderer::buildShared(obstacles, velocities_.getWidth(), velocities_.getHeight(), obstacleThreshold, obstacleInvert) : obstacles,
+           obstaclesEnabled);
+  }
+
+  void render(PingPongFbo& velocities_,
+              ofFbo& pressures_,
+              const ofTexture& obstacleMask,
+              bool obstaclesEnabled) {
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
-    velocities_.getTarget().begin();
     {
       shader.begin();
       const auto texSize = glm::vec2(velocities_.getWidth(), velocities_.getHeight());
       shader.setUniformTexture("pressures", pressures_.getTexture(), 1);
-      shader.setUniformTexture("obstacles", obstacles, 2);
+      shader.setUniformTexture("obstacles", obstacleMask, 2);
       shader.setUniform1i("obstaclesEnabled", obstaclesEnabled ? 1 : 0);
-      shader.setUniform1f("obstacleThreshold", obstacleThreshold);
-      shader.setUniform1i("obstacleInvert", obstacleInvert ? 1 : 0);
       shader.setUniform2f("texSize", texSize);
       shader.setUniform2f("halfInvCell", 0.5f * texSize);
+      shader.setUniform1i("wallBoundary", fusedWallBoundary ? 1 : 0);
       ofSetColor(255);
-      velocities_.getSource().draw(0, 0);
+      drawPass(velocities_.getTarget(), velocities_.getSource().getTexture());
       shader.end();
     }
-    velocities_.getTarget().end();
     velocities_.swap();
     ofPopStyle();
   }
@@ -43,33 +57,45 @@ protected:
     return GLSL(
                 uniform sampler2D tex0; // velocities
                 uniform sampler2D pressures;
-                uniform sampler2D obstacles;
+                uniform sampler2D obstacles; // ObstacleMaskRenderer output
                 uniform int obstaclesEnabled;
-                uniform float obstacleThreshold;
-                uniform int obstacleInvert;
                 uniform vec2 texSize;
                 uniform vec2 halfInvCell;
+                uniform int wallBoundary;
                 in vec2 texCoordVarying;
                 out vec4 fragColor;
 
-                float obstacleMask(vec2 uv) {
-                  vec2 sz = vec2(textureSize(obstacles, 0));
-                  vec2 uvQ = (floor(uv * sz) + 0.5) / sz;
-                  vec4 o = texture(obstacles, uvQ);
-                  float m = max(o.a, dot(o.rgb, vec3(0.333333)));
-                  if (obstacleInvert == 1) m = 1.0 - m;
-                  return m;
+                // ObstacleMaskRenderer bits: 1 = solid, 2/4/8/16 = N/S/E/W neighbour solid.
+                int obstacleBits(vec2 uv) {
+                  if (obstaclesEnabled == 0) return 0;
+                  return int(texture(obstacles, uv).r * 255.0 + 0.5);
                 }
 
                 float obstacleSolid(vec2 uv) {
-                  if (obstaclesEnabled == 0) return 0.0;
-                  return step(obstacleThreshold, obstacleMask(uv));
+                  return float(obstacleBits(uv) & 1);
+                }
+
+                // Neighbour solidity from the centre's mask bits when the mask matches this grid,
+                // otherwise (multigrid coarse levels) by sampling the mask at the neighbour.
+                bool neighborSolid(int bits, int bit, vec2 uv) {
+                  if (textureSize(obstacles, 0) == ivec2(texSize)) return (bits & bit) != 0;
+                  return obstacleSolid(uv) > 0.5;
+                }
+
+                // As VelocityBoundaryShader: zero the wall-normal velocity on the outermost texels.
+                vec4 applyWalls(vec4 c, vec2 uv) {
+                  if (wallBoundary == 0) return c;
+                  vec2 p = uv * texSize;
+                  if (p.x < 1.5 || p.x > texSize.x - 1.5) c.x = 0.0;
+                  if (p.y < 1.5 || p.y > texSize.y - 1.5) c.y = 0.0;
+                  return vec4(c.xy, 0.0, 0.0);
                 }
 
                 void main() {
                   vec2 xy = texCoordVarying.xy;
 
-                  if (obstacleSolid(xy) > 0.5) {
+                  int bits = obstacleBits(xy);
+                  if ((bits & 1) != 0) {
                     fragColor = vec4(0.0);
                     return;
                   }
@@ -78,10 +104,10 @@ protected:
 
                   float pC = texture(pressures, xy).r;
 
-                  float pN = (obstacleSolid(xy + off.yx) > 0.5) ? pC : texture(pressures, xy + off.yx).r;
-                  float pS = (obstacleSolid(xy - off.yx) > 0.5) ? pC : texture(pressures, xy - off.yx).r;
-                  float pE = (obstacleSolid(xy + off.xy) > 0.5) ? pC : texture(pressures, xy + off.xy).r;
-                  float pW = (obstacleSolid(xy - off.xy) > 0.5) ? pC : texture(pressures, xy - off.xy).r;
+                  float pN = neighborSolid(bits, 2, xy + off.yx) ? pC : texture(pressures, xy + off.yx).r;
+                  float pS = neighborSolid(bits, 4, xy - off.yx) ? pC : texture(pressures, xy - off.yx).r;
+                  float pE = neighborSolid(bits, 8, xy + off.xy) ? pC : texture(pressures, xy + off.xy).r;
+                  float pW = neighborSolid(bits, 16, xy - off.xy) ? pC : texture(pressures, xy - off.xy).r;
 
                   vec2 grad = vec2(pE - pW, pN - pS) * halfInvCell;
 
@@ -89,7 +115,11 @@ protected:
                   vec2 newV = oldV - grad;
 
                   fragColor.rg = newV;
+                  fragColor = applyWalls(fragColor, xy);
                 }
                 );
   }
+
+private:
+  bool fusedWallBoundary = false;
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Shader.h"
+
+// Writes one texel per tile of the velocity field: 1 if any cell in the tile moves faster than
+// velocityThreshold or holds a value channel above valueThreshold, else 0. The target is a
+// tilesX x tilesY single-channel fbo (see TileCoverage::getTileCount()).
+class TileActivityShader : public Shader {
+
+public:
+  void render(ofFbo& activity,
+              const ofTexture& velocities,
+              const ofTexture& values,
+              int tileSize,
+              float velocityThreshold,
+              float valueThreshold) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    shader.setUniformTexture("values", values, 1);
+    shader.setUniform1i("tileSize", tileSize);
+    shader.setUniform1f("velocityThreshold2", velocityThreshold * velocityThreshold);
+    shader.setUniform1f("valueThreshold", valueThreshold);
+    drawPass(activity, velocities);
+    shader.end();
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0; // velocities
+                uniform sampler2D values;
+                uniform int tileSize;
+                uniform float velocityThreshold2;
+                uniform float valueThreshold;
+                out vec4 fragColor;
+
+                void main() {
+                  ivec2 fieldSize = textureSize(tex0, 0);
+                  ivec2 first = ivec2(gl_FragCoord.xy) * tileSize;
+                  ivec2 last = min(first + tileSize, fieldSize);
+
+                  float active = 0.0;
+                  for (int y = first.y; y < last.y && active == 0.0; ++y) {
+                    for (int x = first.x; x < last.x; ++x) {
+                      vec2 v = texelFetch(tex0, ivec2(x, y), 0).xy;
+                      vec4 c = abs(texture(values, (vec2(x, y) + 0.5) / vec2(fieldSize)));
+                      if (dot(v, v) > velocityThreshold2 || max(max(c.r, c.g), max(c.b, c.a)) > valueThreshold) {
+                        active = 1.0;
+                        break;
+                      }
+                    }
+                  }
+
+                  fragColor = vec4(active, 0.0, 0.0, 1.0);
+                }
+                );
+  }
+};
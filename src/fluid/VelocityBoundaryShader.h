@@ -9,15 +9,13 @@ public:
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
 
-    velocities.getTarget().begin();
     shader.begin();
     {
       shader.setUniformTexture("tex0", velocities.getSource().getTexture(), 1);
       shader.setUniform2f("texSize", glm::vec2(velocities.getWidth(), velocities.getHeight()));
-      velocities.getSource().draw(0, 0);
+      drawPass(velocities.getTarget(), velocities.getSource().getTexture());
     }
     shader.end();
-    velocities.getTarget().end();
 
     velocities.swap();
     ofPopStyle();
@@ -9,16 +9,14 @@ public:
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
 
-    velocities.getTarget().begin();
     shader.begin();
     {
       shader.setUniformTexture("tex0", velocities.getSource().getTexture(), 0);
       shader.setUniform1f("dt", dt);
       shader.setUniform1f("maxDisp", maxDispUv);
-      velocities.getSource().draw(0, 0);
+      drawPass(velocities.getTarget(), velocities.getSource().getTexture());
     }
     shader.end();
-    velocities.getTarget().end();
 
     velocities.swap();
 
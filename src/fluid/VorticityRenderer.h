@@ -12,14 +12,12 @@ public:
   void render(const ofBaseDraws& velocities_) override {
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
-    fbo.begin();
     shader.begin();
     const auto texSize = glm::vec2(fbo.getWidth(), fbo.getHeight());
     shader.setUniform2f("texSize", texSize);
     shader.setUniform2f("halfInvCell", 0.5f * texSize);
-    velocities_.draw(0, 0, fbo.getWidth(), fbo.getHeight());
+    drawPass(fbo, velocities_);
     shader.end();
-    fbo.end();
     ofPopStyle();
   }
 
@@ -11,11 +11,13 @@ public:
   void render(PingPongFbo& fbo_, const ofTexture& addedTexture_, float multiplier_, float offset_ = 0.0f) {
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo_.getTarget().begin();
     shader.begin();
     shader.setUniformTexture("addedTexture", addedTexture_, 1);
     shader.setUniform1f("multiplier", multiplier_);
     shader.setUniform1f("offset", offset_);
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     fbo_.getSource().draw(0, 0);
     shader.end();
     fbo_.getTarget().end();
@@ -15,12 +15,14 @@ class ClampShader : public Shader {
 public:
   void render(const ofBaseDraws& drawable) {
     shader.begin();
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     drawable.draw(0, 0);
     shader.end();
   }
   
   void render(PingPongFbo& fbo_)
   {
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo_.getTarget().begin();
     render(fbo_.getSource());
     fbo_.getTarget().end();
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Shader.h"
+
+// Box-filters a texture down by an integer factor: each output texel is the mean of the
+// factor x factor block of source texels it covers (clipped at the source's edges).
+class DownsampleShader : public Shader {
+
+public:
+  void render(ofFbo& target, const ofTexture& source, int factor) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    shader.setUniform1i("factor", factor);
+    drawPass(target, source);
+    shader.end();
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0;
+                uniform int factor;
+                out vec4 fragColor;
+
+                void main() {
+                  ivec2 sourceSize = textureSize(tex0, 0);
+                  ivec2 first = ivec2(gl_FragCoord.xy) * factor;
+                  ivec2 last = min(first + factor, sourceSize);
+
+                  vec4 sum = vec4(0.0);
+                  for (int y = first.y; y < last.y; ++y) {
+                    for (int x = first.x; x < last.x; ++x) {
+                      sum += texelFetch(tex0, ivec2(x, y), 0);
+                    }
+                  }
+                  vec2 count = vec2(max(last - first, ivec2(1)));
+                  fragColor = sum / (count.x * count.y);
+                }
+                );
+  }
+};
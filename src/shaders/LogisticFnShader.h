@@ -11,6 +11,7 @@ public:
     ofEnableBlendMode(OF_BLENDMODE_ALPHA);
     shader.begin();
     shader.setUniform4f("clampFactor", clampFactor);
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     drawable.draw(0, 0);
     shader.end();
     ofPopStyle();
@@ -20,6 +21,7 @@ public:
   void render(PingPongFbo& fbo_,
               glm::vec4 clampFactor)
   {
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo_.getTarget().begin();
     render(fbo_.getSource(), clampFactor);
     fbo_.getTarget().end();
@@ -11,6 +11,7 @@ public:
     shader.setUniform1i("invert", invert);
     shader.setUniform2f("scaleCentre", scaleCentre);
     shader.setUniform2f("foregroundScale", foregroundScale);
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     foreground.draw(0, 0, width, height);
     shader.end();
   }
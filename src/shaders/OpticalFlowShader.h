@@ -16,6 +16,7 @@ public:
     shader.setUniform1f("power", powerParameter);
     shader.setUniformTexture("lastFrame", lastFrame_.getTexture(), 1);
     shader.setUniform2f("texSize", glm::vec2(currentFrame_.getWidth(), currentFrame_.getHeight()));
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     currentFrame_.draw(0, 0, w, h);
     shader.end();
     ofPopStyle();
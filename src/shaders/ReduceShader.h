@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Shader.h"
+
+// One step of a max/sum reduction: each output texel covers a FACTOR x FACTOR block of the input.
+// The first step maps the field to a magnitude m (|r| or |rg|) and writes (max m, sum m^2);
+// later steps combine those pairs.
+class ReduceShader : public Shader {
+
+public:
+  static constexpr int FACTOR = 4;
+
+  enum class Input {
+    Scalar = 0,  // magnitude of r
+    Vector = 1,  // magnitude of rg
+    Reduced = 2, // output of a previous step
+  };
+
+  void render(ofFbo& target, const ofTexture& source, Input input) {
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    shader.begin();
+    shader.setUniform1i("inputMode", static_cast<int>(input));
+    shader.setUniform2i("sourceSize", static_cast<int>(source.getWidth()), static_cast<int>(source.getHeight()));
+    drawPass(target, source);
+    shader.end();
+    ofPopStyle();
+  }
+
+protected:
+  std::string getFragmentShader() override {
+    return GLSL(
+                uniform sampler2D tex0;
+                uniform int inputMode;
+                uniform ivec2 sourceSize;
+                out vec4 fragColor;
+
+                void main() {
+                  ivec2 base = ivec2(gl_FragCoord.xy) * 4;
+                  float maxValue = 0.0;
+                  float sumValue = 0.0;
+                  for (int j = 0; j < 4; ++j) {
+                    for (int i = 0; i < 4; ++i) {
+                      ivec2 p = base + ivec2(i, j);
+                      if (p.x >= sourceSize.x || p.y >= sourceSize.y) continue;
+                      vec4 t = texelFetch(tex0, p, 0);
+                      if (inputMode == 2) {
+                        maxValue = max(maxValue, t.r);
+                        sumValue += t.g;
+                      } else {
+                        float m = (inputMode == 1) ? length(t.rg) : abs(t.r);
+                        maxValue = max(maxValue, m);
+                        sumValue += m * m;
+                      }
+                    }
+                  }
+                  fragColor = vec4(maxValue, sumValue, 0.0, 1.0);
+                }
+                );
+  }
+};
@@ -56,6 +56,8 @@ public:
               ofTexture& field1Texture_, float field1Multiplier_, glm::vec2 field1Bias_,
               ofTexture& field2Texture_, float field2Multiplier_, glm::vec2 field2Bias_,
               GridParameters gridParams = defaultGridParameters) {
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo_.getTarget().begin();
     {
       shader.begin();
@@ -78,6 +80,7 @@ public:
       shader.setUniform1f("ghostBlend", gridParams.ghostBlend);
       shader.setUniform2f("foldPeriod", gridParams.foldPeriod);
 
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
       fbo_.getSource().draw(0, 0);
       shader.end();
     }
@@ -88,6 +91,8 @@ public:
   void render(PingPongFbo& fbo_, glm::vec2 translateBy_, float mixNew_, float fadeMultiplier_,
               ofTexture& field1Texture_, float field1Multiplier_, glm::vec2 field1Bias_,
               GridParameters gridParams = defaultGridParameters) {
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo_.getTarget().begin();
     {
       shader.begin();
@@ -110,6 +115,7 @@ public:
       shader.setUniform1f("ghostBlend", gridParams.ghostBlend);
       shader.setUniform2f("foldPeriod", gridParams.foldPeriod);
 
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
       fbo_.getSource().draw(0, 0);
       shader.end();
     }
@@ -119,6 +125,8 @@ public:
 
   void render(PingPongFbo& fbo_, glm::vec2 translateBy_, float mixNew_, float fadeMultiplier_,
               GridParameters gridParams = defaultGridParameters) {
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+    OFXRENDERER_GL_COUNT(fboBinds, 2);
     fbo_.getTarget().begin();
     {
       shader.begin();
@@ -141,6 +149,7 @@ public:
       shader.setUniform1f("ghostBlend", gridParams.ghostBlend);
       shader.setUniform2f("foldPeriod", gridParams.foldPeriod);
 
+      OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
       fbo_.getSource().draw(0, 0);
       shader.end();
     }
@@ -8,15 +8,31 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <vector>
 
 #include "Shader.h"
-#include "UnitQuadMesh.h"
+#include "InstancedUnitQuad.h"
 #include "ofGraphics.h"
 
 class SoftCircleShader : public Shader {
 
 public:
+  struct Stamp {
+    glm::vec2 center;
+    glm::vec2 size;
+    float angleRad = 0.0f;
+    ofFloatColor color;
+    float fadeWidth = 0.3f;
+    int falloff = 0; // 0 = Glow, 1 = Dab
+    float edgeAmount = 0.0f;
+    glm::vec3 edgeFreq { 3.0f, 5.0f, 9.0f };
+    float edgeSharpness = 1.0f;
+    float edgePhase = 0.0f;
+  };
+
   // falloff: 0 = Glow (default), 1 = Dab
   void render(glm::vec2 center, float radius, ofFloatColor color, float fadeWidth = 0.3, int falloff = 0) {
     render(center,
@@ -41,39 +57,94 @@ public:
               glm::vec3 edgeFreq = glm::vec3 { 3.0f, 5.0f, 9.0f },
               float edgeSharpness = 1.0,
               float edgePhase = 0.0) {
-    shader.begin();
-    shader.setUniform1f("fadeWidth", fadeWidth);
-    shader.setUniform4f("color", color);
-    shader.setUniform1i("falloff", falloff);
-    shader.setUniform1f("edgeAmount", edgeAmount);
-    shader.setUniform3f("edgeFreq", edgeFreq);
-    shader.setUniform1f("edgeSharpness", edgeSharpness);
-    shader.setUniform1f("edgePhase", edgePhase);
+    const Stamp stamp { center, size, angleRad, color, fadeWidth, falloff, edgeAmount, edgeFreq, edgeSharpness, edgePhase };
+    renderBatch({ &stamp, 1 });
+  }
 
-    // Per-stamp seed avoids repeated edge patterns.
-    shader.setUniform1f("edgeSeed", hashSeed(center));
+  // Draws every stamp with one instanced draw. Per-stamp parameters travel in a per-instance
+  // vertex buffer, so the cost per stamp is a 72-byte copy rather than a round of uniform
+  // updates and a mesh submission. Blend state is the caller's, as for render().
+  void renderBatch(std::span<const Stamp> stamps) {
+    if (stamps.empty()) return;
+    OFXRENDERER_TRACE_SHADER_SCOPE();
+
+    instances.resize(stamps.size());
+    for (size_t i = 0; i < stamps.size(); ++i) {
+      const Stamp& stamp = stamps[i];
+      instances[i] = {
+        { stamp.center.x, stamp.center.y, stamp.size.x, stamp.size.y },
+        { stamp.color.r, stamp.color.g, stamp.color.b, stamp.color.a },
+        // Per-stamp seed avoids repeated edge patterns.
+        { stamp.angleRad, stamp.fadeWidth, static_cast<float>(stamp.falloff), hashSeed(stamp.center) },
+        { stamp.edgeFreq.x, stamp.edgeFreq.y, stamp.edgeFreq.z, stamp.edgeSharpness },
+        { stamp.edgeAmount, stamp.edgePhase },
+      };
+    }
 
+    shader.begin();
     // Gentle drift keeps edges alive without buzzing.
     shader.setUniform1f("timeSec", ofGetElapsedTimef());
-
-    quadMesh.draw(center, size, angleRad);
+    quad.draw(instances.data(), instances.size());
     shader.end();
   }
 
 protected:
+  std::string getVertexShader() override {
+    return GLSL(
+                uniform mat4 modelViewProjectionMatrix;
+                layout(location = 0) in vec4 position;
+                layout(location = 3) in vec2 texcoord;
+                layout(location = 4) in vec4 instanceCenterSize;
+                layout(location = 5) in vec4 instanceColor;
+                layout(location = 6) in vec4 instanceParams; // angle, fadeWidth, falloff, edgeSeed
+                layout(location = 7) in vec4 instanceEdge; // edgeFreq, edgeSharpness
+                layout(location = 8) in vec2 instanceEdgeAmountPhase;
+
+                out vec2 texCoordVarying;
+                flat out vec4 color;
+                flat out float fadeWidth;
+                flat out int falloff;
+                flat out float edgeAmount;
+                flat out vec3 edgeFreq;
+                flat out float edgeSharpness;
+                flat out float edgePhase;
+                flat out float edgeSeed;
+
+                void main() {
+                  // Same transform as translate(center) * rotate(angle) * scale(size) on the unit quad.
+                  float angle = instanceParams.x;
+                  float c = cos(angle);
+                  float s = sin(angle);
+                  vec2 local = position.xy * instanceCenterSize.zw;
+                  vec2 rotated = vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+                  gl_Position = modelViewProjectionMatrix * vec4(instanceCenterSize.xy + rotated, 0.0, 1.0);
+
+                  texCoordVarying = texcoord;
+                  color = instanceColor;
+                  fadeWidth = instanceParams.y;
+                  falloff = int(instanceParams.z + 0.5);
+                  edgeSeed = instanceParams.w;
+                  edgeFreq = instanceEdge.xyz;
+                  edgeSharpness = instanceEdge.w;
+                  edgeAmount = instanceEdgeAmountPhase.x;
+                  edgePhase = instanceEdgeAmountPhase.y;
+                }
+    );
+  }
+
   std::string getFragmentShader() override {
     return GLSL(
                 in vec2 texCoordVarying;
                 out vec4 fragColor;
 
-                uniform float fadeWidth;
-                uniform vec4 color;
-                uniform int falloff; // 0 = Glow, 1 = Dab
-                uniform float edgeAmount; // 0 = none
-                uniform vec3 edgeFreq; // angular frequencies
-                uniform float edgeSharpness; // >1 = spikier
-                uniform float edgePhase;
-                uniform float edgeSeed; // per-stamp seed in [0,1)
+                flat in float fadeWidth;
+                flat in vec4 color;
+                flat in int falloff; // 0 = Glow, 1 = Dab
+                flat in float edgeAmount; // 0 = none
+                flat in vec3 edgeFreq; // angular frequencies
+                flat in float edgeSharpness; // >1 = spikier
+                flat in float edgePhase;
+                flat in float edgeSeed; // per-stamp seed in [0,1)
                 uniform float timeSec; // time, for gentle drift
 
                 void main() {
@@ -166,5 +237,24 @@ private:
     return static_cast<float>(h & 0x00FFFFFFu) * (1.0f / 16777216.0f);
   }
 
-  UnitQuadMesh quadMesh;
+  // Layout of one instance in the per-instance vertex buffer; see the vertex shader.
+  struct StampInstance {
+    float centerSize[4];
+    float color[4];
+    float params[4];
+    float edge[4];
+    float edgeAmountPhase[2];
+  };
+
+  std::vector<StampInstance> instances;
+  InstancedUnitQuad quad {
+    {
+      { 4, 4, offsetof(StampInstance, centerSize) },
+      { 5, 4, offsetof(StampInstance, color) },
+      { 6, 4, offsetof(StampInstance, params) },
+      { 7, 4, offsetof(StampInstance, edge) },
+      { 8, 2, offsetof(StampInstance, edgeAmountPhase) },
+    },
+    sizeof(StampInstance)
+  };
 };
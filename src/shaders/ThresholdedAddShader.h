@@ -18,6 +18,7 @@ public:
     ofPushStyle();
     ofEnableBlendMode(OF_BLENDMODE_DISABLED);
     ofSetColor(255);
+    OFXRENDERER_GL_COUNT_TEXTURE_DRAW();
     existingFbo_.draw(0, 0);
     
     shader.begin();
@@ -22,6 +22,7 @@ public:
              float saturation = 1.0,
              float brightness = 0.0,
              float hueShift = 0.0) {
+    OFXRENDERER_TRACE_BEGIN("TonemapShader");
     shader.begin();
     shader.setUniform1i("u_tonemapType", tonemapType);
     shader.setUniform1f("u_exposure", exposure);
@@ -35,6 +36,7 @@ public:
   
   void end() {
     shader.end();
+    OFXRENDERER_TRACE_END();
   }
   
   std::string getFragmentShader() override {